@@ -1,3 +1,5 @@
+// C simulation testbench for the solver core, it also runs on the host from the repository root with:
+//   g++ -Ihost/include -Ihardware -o testbench hardware/testbench.cpp -x c++ hardware/toplevel.c
 //top: 6, bottom: 5, left: 1, right: 6
 //top: 4, bottom: 6, left: 6, right: 7
 //top: 6, bottom: 2, left: 7, right: 3
@@ -11,6 +13,44 @@
 #define LEFT(x) 	((uint8_t *)(x))[2]
 #define RIGHT(x) 	((uint8_t *)(x))[3]
 
+// A 10x10 puzzle where every edge has a colour of its own, so its only layouts are the one it was made from turned round
+// Carrying on after each full grid backtracks from one past the last position, so this checks the core's stack has
+// room for that. It needs 220 colours so it can't be run on a PACKED_TILES build
+int check_full_grid_resume()
+{
+	uint32_t tiles[100];
+	uint8_t across[11][10], down[10][11];
+	uint8_t colour = 1;
+	for (int y = 0; y < 11; y++)
+		for (int x = 0; x < 10; x++)
+			across[y][x] = colour++;
+	for (int y = 0; y < 10; y++)
+		for (int x = 0; x < 11; x++)
+			down[y][x] = colour++;
+	// In ram a tile is top, bottom, left then right from the lowest byte
+	for (int y = 0; y < 10; y++)
+		for (int x = 0; x < 10; x++)
+			tiles[y * 10 + x] = across[y][x] | (across[y + 1][x] << 8) | (down[y][x] << 16) | ((uint32_t)down[y][x + 1] << 24);
+
+	uint1 reset = 1, abort = 0;
+	uint4 size = 10;
+	uint8 start_idx = 0, end_idx = 100;
+	uint32 budget = 0;
+	uint16 seed = 0;
+	uint8 batch = 0;
+	uint32 filter[SOLUTION_FILTER_WORDS] = {0};
+
+	int solutions = 0;
+	uint2 result;
+	while ((result = toplevel(tiles, filter, &reset, &size, &start_idx, &end_idx, &abort, &budget, &seed, &batch)) == TOPLEVEL_SOLUTION)
+	{
+		reset = 0;
+		if (++solutions > 4)
+			break;
+	}
+	printf("10x10 resume: %d solutions, result %d\n", solutions, (int)result);
+	return solutions == 4 && result == TOPLEVEL_DONE;
+}
 
 int main()
 {
@@ -22,9 +62,17 @@ int main()
 	tiles[2] = MAKE_TILE(6, 2, 7, 3);
 	tiles[3] = MAKE_TILE(0, 7, 6, 4);
 
-	uint32_t sol;
+	uint1 reset = 1, abort = 0;
+	uint4 size = 2;
+	uint8 start_idx = 0, end_idx = 2 * 2;
+	uint32 budget = 0;
+	uint16 seed = 0;
+	uint8 batch = 0;
+
+	uint32 filter[SOLUTION_FILTER_WORDS] = {0};
 
-	toplevel(tiles, 2, 0, 2 * 2, &sol);
+	uint2 result = toplevel(tiles, filter, &reset, &size, &start_idx, &end_idx, &abort, &budget, &seed, &batch);
+	printf("result: %d\n", (int)result);
 
 
 
@@ -38,4 +86,13 @@ int main()
 		right = RIGHT(&tile);
 		printf("top: %d, bottom: %d, left: %d, right: %d\n", top, bottom, left, right);
 	}
+
+#ifndef PACKED_TILES
+	if (!check_full_grid_resume())
+	{
+		printf("FAIL\n");
+		return 1;
+	}
+#endif
+	return 0;
 }
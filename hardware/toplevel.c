@@ -2,19 +2,43 @@
 #include <string.h>
 #define MAX_TILES MAX_SIZE * MAX_SIZE
 
+// How a tile is held inside the core
+// By default it is as in ram, a byte for each edge, with PACKED_TILES defined at synthesis each edge is 5 bits
+// so a tile is 20 bits and the tile, grid and stack memories shrink, colours then have to be below 32
+#ifdef PACKED_TILES
+#define EDGE_BITS 5
+typedef uint20 tile_word;
+#else
+#define EDGE_BITS 8
+typedef uint32 tile_word;
+#endif
+#define EDGE_MASK ((1 << EDGE_BITS) - 1)
+
 // These defines are used get the colour values for each segment of the tile
-#define TOP(x) 		(((uint8 *)(x))[0])
-#define BOTTOM(x) 	(((uint8 *)(x))[1])
-#define LEFT(x) 	(((uint8 *)(x))[2])
-#define RIGHT(x) 	(((uint8 *)(x))[3])
+#define TOP(x) 		((x) & EDGE_MASK)
+#define BOTTOM(x) 	(((x) >> EDGE_BITS) & EDGE_MASK)
+#define LEFT(x) 	(((x) >> (2 * EDGE_BITS)) & EDGE_MASK)
+#define RIGHT(x) 	(((x) >> (3 * EDGE_BITS)) & EDGE_MASK)
+// Each colour is masked so one that is too big for the field can't spill into the next edge
+#define MAKE_TILE(top, bottom, left, right) \
+	((tile_word)((top) & EDGE_MASK) | ((tile_word)((bottom) & EDGE_MASK) << EDGE_BITS) | \
+	((tile_word)((left) & EDGE_MASK) << (2 * EDGE_BITS)) | ((tile_word)((right) & EDGE_MASK) << (3 * EDGE_BITS)))
+
+// A tile in ram is always a byte for each edge, in the order top, bottom, left, right
+#define RAM_EDGE(x, n) (((x) >> ((n) * 8)) & 0xFF)
 
 // This struct is used to store the information that we require for back tracking
 // We need to know the index of the tile at the current position
 // We also need to know the rotation of that tile in the event of a back track
 typedef struct stack_item_s
 {
+#ifdef PACKED_TILES
+	uint7 idx;
+	uint2 rot;
+#else
 	uint8 idx;
 	uint3 rot;
+#endif
 } stack_item_t;
 
 
@@ -23,78 +47,140 @@ void inc_current();
 void backtrack();
 uint1 get_tile();
 uint1 valid_x(uint8 idx);
-uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot);
-uint32 clockwise_rotate(uint32 tile);
+uint1 check_tile(uint8 pos, tile_word tile, uint3 init_rot);
+void place_tile(uint8 pos, tile_word tile, uint3 rot);
+tile_word clockwise_rotate(tile_word tile);
+void shuffle_order(uint16 seed);
+uint8 candidate(uint8 pos);
+uint32 cell_hash(uint8 pos, tile_word tile);
+uint32 grid_hash();
+uint1 seen_solution(uint32 *filter);
+void filter_add(uint32 *filter);
+void reset_search(uint32 *src, uint4 in_size, uint8 in_start_idx, uint8 in_end_idx, uint16 seed);
+uint2 search(uint32 *filter, uint1 *abort, uint32 budget);
+void write_grid(uint32 *dst);
+void search_batch(uint32 *descs, uint32 *filter, uint8 count, uint1 *abort);
+
+// The search state kept between calls, this is empty for synthesis
+// Host builds that run several cores as threads define it as static __thread so each thread has its own
+#ifndef CORE_STATE
+#define CORE_STATE
+#endif
 
 //This is the list of tiles given to the system from the memory
-uint32 tiles[MAX_TILES];
+CORE_STATE tile_word tiles[MAX_TILES];
 // This marks whether the tile at the current index is being used in the current solution
-uint1 used[MAX_TILES];
+CORE_STATE uint1 used[MAX_TILES];
+// The order tiles are tried in after the first position, the stack holds positions in this rather than tile indexes
+// It is shuffled from the seed on reset so a restart with a new seed makes different early choices
+CORE_STATE uint8 order[MAX_TILES];
 // This holds the current solution
-uint32 current_grid[MAX_TILES];
+CORE_STATE tile_word current_grid[MAX_TILES];
 // The stack so that we can perform back tracking
 // The stack is an array of stack items where the index is equavilent to the index in current_grid
 // Therefore each part of this array stores information about currently filled in tiles
 // It also gives us enough information about previous tiles used in the that position in the current tile configuration
-stack_item_t stack[MAX_TILES];
+// There is one more entry than there are tiles, carrying on after a full grid starts from the position past the last
+CORE_STATE stack_item_t stack[MAX_TILES + 1];
 
 // The current index in the current_grid and stack array
-uint8 current_idx;
+CORE_STATE uint8 current_idx;
 // This is the x and y values for the corresponding current_idx
 // Storing these means we no longer require to perform division or module to figure them out
 // This saves both space and computation time
-uint4 current_y;
-uint4 current_x;
+CORE_STATE uint4 current_y;
+CORE_STATE uint4 current_x;
 
 // Size of the puzzle and total tiles in puzzle
-uint4 size;
-uint8 total_size;
+CORE_STATE uint4 size;
+CORE_STATE uint8 total_size;
 
 // This defines the whole search space this IP core is going to run in
 // It starts the first itme in the grid with the tile in ram at the given start index
-uint8 start_idx;
+CORE_STATE uint8 start_idx;
 // Same as above but for end index
-uint8 end_idx;
+CORE_STATE uint8 end_idx;
 
-uint1 toplevel(uint32 *ram, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, uint8 *in_end_idx, uint1 *abort)
+uint2 toplevel(uint32 *ram, uint32 *filter, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, uint8 *in_end_idx,
+		uint1 *abort, uint32 *in_budget, uint16 *in_seed, uint8 *in_batch)
 {
 	#pragma HLS INTERFACE m_axi port=ram offset=slave bundle=MAXI
+	#pragma HLS INTERFACE m_axi port=filter offset=slave bundle=MAXI
 	#pragma HLS INTERFACE s_axilite port=reset bundle=AXILiteS register
 	#pragma HLS INTERFACE s_axilite port=in_size bundle=AXILiteS register
 	#pragma HLS INTERFACE s_axilite port=in_start_idx bundle=AXILiteS register
 	#pragma HLS INTERFACE s_axilite port=in_end_idx bundle=AXILiteS register
 	#pragma HLS INTERFACE s_axilite port=abort bundle=AXILiteS register
+	#pragma HLS INTERFACE s_axilite port=in_budget bundle=AXILiteS register
+	#pragma HLS INTERFACE s_axilite port=in_seed bundle=AXILiteS register
+	#pragma HLS INTERFACE s_axilite port=in_batch bundle=AXILiteS register
 	#pragma HLS INTERFACE s_axilite port=return bundle=AXILiteS register
+#ifdef PARALLEL_CANDIDATES
+	// Every tile is compared at once so each needs its own registers
+	#pragma HLS ARRAY_PARTITION variable=tiles complete
+	#pragma HLS ARRAY_PARTITION variable=used complete
+	#pragma HLS ARRAY_PARTITION variable=order complete
+#endif
+
+	// A batch of small puzzles is solved back to back without the software setting up and starting the core for each
+	if (*in_batch != 0)
+	{
+		search_batch(ram, filter, *in_batch, abort);
+		return TOPLEVEL_DONE;
+	}
 
 	// If the reset pin is high then we want to rest the data
 	// This means we only reset when required making it trivial to get multiple solutions from a single IP core
 	if (*reset)
+		reset_search(ram, *in_size, *in_start_idx, *in_end_idx, *in_seed);
+
+	// This tells the software whether the search space has been completed or not
+	// And therefore whether to start the IP core again once the puzzle solution has been retrieved
+	uint2 cont = search(filter, abort, *in_budget);
+	if (cont == TOPLEVEL_SOLUTION)
+		write_grid(ram);
+
+	return cont;
+}
+
+void reset_search(uint32 *src, uint4 in_size, uint8 in_start_idx, uint8 in_end_idx, uint16 seed)
+{
+#ifdef PACKED_TILES
+	load_loop:for (uint8 i = 0; i < MAX_TILES; i++)
 	{
-		memcpy(&tiles, ram, MAX_TILES * sizeof(uint32));
-		memset(&used, 0, MAX_TILES * sizeof(uint1));
-		//memset(&current_grid, 0, MAX_TILES * sizeof(uint32));
-		for (uint8 i = 0; i < MAX_TILES; i++)
-		{
-			stack[i].idx = 0;
-			stack[i].rot = 0;
-		}
+		uint32 tile = src[i];
+		tiles[i] = MAKE_TILE(RAM_EDGE(tile, 0), RAM_EDGE(tile, 1), RAM_EDGE(tile, 2), RAM_EDGE(tile, 3));
+	}
+#else
+	memcpy(&tiles, src, MAX_TILES * sizeof(uint32));
+#endif
+	memset(&used, 0, MAX_TILES * sizeof(uint1));
+	//memset(&current_grid, 0, MAX_TILES * sizeof(uint32));
+	for (uint8 i = 0; i <= MAX_TILES; i++)
+	{
+		stack[i].idx = 0;
+		stack[i].rot = 0;
+	}
 
-		start_idx = *in_start_idx;
-		end_idx = *in_end_idx;
+	start_idx = in_start_idx;
+	end_idx = in_end_idx;
 
-		stack[0].idx = start_idx;
+	stack[0].idx = start_idx;
 
-		current_idx = 0;
-		current_y = 0;
-		current_x = 0;
+	current_idx = 0;
+	current_y = 0;
+	current_x = 0;
 
-		size = *in_size;
-		total_size = size * size;
-	}
+	size = in_size;
+	total_size = size * size;
 
-	// This tells the software whether the search space has been completed or not
-	// And therefore whether to start the IP core again once the puzzle solution has been retrieved
-	uint1 cont = 0;
+	shuffle_order(seed);
+}
+
+uint2 search(uint32 *filter, uint1 *abort, uint32 budget)
+{
+	// Each pass of the main loop places or takes back one tile, a budget of 0 never runs out
+	uint32 nodes = 0;
 
 	// This while loop allows search throughout all of the defined search space from start_idx to end_idx
 	main_loop:while(stack[0].idx < end_idx)
@@ -103,6 +189,11 @@ uint1 toplevel(uint32 *ram, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, u
 		if (*abort == 1)
 			break;
 
+		// Stop where we are once the budget is spent, the software then either carries on or restarts with a new seed
+		if (budget != 0 && nodes == budget)
+			return TOPLEVEL_BUDGET;
+		nodes++;
+
 
 		// This finds and inserts a valid tile into the working solution if there is one
 		// If there isn't then we back track
@@ -111,53 +202,159 @@ uint1 toplevel(uint32 *ram, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, u
 		{
 			backtrack();
 		}
-		// If it was successful and we've filled the solution grid then write the solution to memory and exit
+		// If it was successful and we've filled the solution grid then stop with it in current_grid
 		// And tell the software that there is still search space left to search
 		else if (succ && current_idx == total_size)
 		{
-			memcpy(ram, &current_grid, MAX_TILES * sizeof(uint32));
-			cont = 1;
-			break;
+			// A solution the software already has, maybe turned round, is not written back and the search carries on
+			if (seen_solution(filter))
+				continue;
+			return TOPLEVEL_SOLUTION;
 		}
 	}
 
-	return cont;
+	return TOPLEVEL_DONE;
+}
+
+void write_grid(uint32 *dst)
+{
+#ifdef PACKED_TILES
+	store_loop:for (uint8 i = 0; i < MAX_TILES; i++)
+	{
+		tile_word tile = current_grid[i];
+		dst[i] = TOP(tile) | (BOTTOM(tile) << 8) | (LEFT(tile) << 16) | ((uint32)RIGHT(tile) << 24);
+	}
+#else
+	memcpy(dst, &current_grid, MAX_TILES * sizeof(uint32));
+#endif
+}
+
+void search_batch(uint32 *descs, uint32 *filter, uint8 count, uint1 *abort)
+{
+	batch_loop:for (uint8 p = 0; p < count; p++)
+	{
+		uint32 *desc = descs + p * BATCH_DESC_WORDS;
+		uint4 puzzle_size = desc[BATCH_SIZE];
+		memset(filter, 0, SOLUTION_FILTER_WORDS * sizeof(uint32));
+		reset_search(desc + BATCH_TILES, puzzle_size, 0, puzzle_size * puzzle_size, 0);
+
+		uint8 found = 0;
+		uint8 flags = 0;
+		solution_loop:while (1)
+		{
+			uint2 result = search(filter, abort, 0);
+			if (result != TOPLEVEL_SOLUTION)
+			{
+				if (*abort == 1)
+					flags = BATCH_ABORTED;
+				break;
+			}
+			write_grid(desc + BATCH_SOLUTION(found));
+			filter_add(filter);
+			found++;
+			if (found == BATCH_MAX_SOLUTIONS)
+			{
+				flags = BATCH_FULL;
+				break;
+			}
+		}
+
+		desc[BATCH_SOLUTIONS] = found;
+		desc[BATCH_FLAGS] = flags;
+		// The rest of the batch is left alone once aborted, its counts are whatever the software cleared them to
+		if (flags == BATCH_ABORTED)
+			break;
+	}
 }
 
+#ifdef PARALLEL_CANDIDATES
+// With PARALLEL_CANDIDATES defined at synthesis every tile in every rotation is compared against the position in one go
+// It takes the same tile and rotation as the loop below, but in a few cycles rather than up to 4 for each tile
+uint1 get_tile()
+{
+	// The edges the position has to match, the top row and left column have nothing to match on that side
+	uint1 need_top = current_y != 0;
+	uint1 need_left = current_x != 0;
+	uint8 up = need_top ? BOTTOM(current_grid[current_idx - size]) : 0;
+	uint8 left = need_left ? RIGHT(current_grid[current_idx - 1]) : 0;
+	uint8 first = stack[current_idx].idx;
+
+	// A bit for each position in the order saying whether its tile fits, and the fewest turns it needs to
+	uint1 match[MAX_TILES];
+	uint2 match_rot[MAX_TILES];
+	compare_loop:for (uint8 pos = 0; pos < MAX_TILES; pos++)
+	{
+		#pragma HLS UNROLL
+		uint8 idx = candidate(pos);
+		tile_word tile = tiles[idx];
+		// The top and left edges after 0, 1, 2 and 3 clockwise turns
+		uint1 fits0 = (!need_top || TOP(tile) == up) && (!need_left || LEFT(tile) == left);
+		uint1 fits1 = (!need_top || LEFT(tile) == up) && (!need_left || BOTTOM(tile) == left);
+		uint1 fits2 = (!need_top || BOTTOM(tile) == up) && (!need_left || RIGHT(tile) == left);
+		uint1 fits3 = (!need_top || RIGHT(tile) == up) && (!need_left || TOP(tile) == left);
+		match[pos] = pos >= first && pos < total_size && !used[idx] && (fits0 || fits1 || fits2 || fits3);
+		match_rot[pos] = fits0 ? 0 : fits1 ? 1 : fits2 ? 2 : 3;
+	}
+
+	// Priority encoder, the lowest position that fits wins
+	uint8 best = MAX_TILES;
+	uint2 best_rot = 0;
+	encode_loop:for (int pos = MAX_TILES - 1; pos >= 0; pos--)
+	{
+		#pragma HLS UNROLL
+		if (match[pos])
+		{
+			best = pos;
+			best_rot = match_rot[pos];
+		}
+	}
+	if (best == MAX_TILES)
+		return 0;
+
+	tile_word tile = tiles[candidate(best)];
+	turn_loop:for (uint2 r = 0; r < best_rot; r++)
+		tile = clockwise_rotate(tile);
+	place_tile(best, tile, best_rot);
+	return 1;
+}
+#else
 uint1 get_tile()
 {
 	// When search for a tile we search from the last position where a tile was successfully found in the current working solution
 	// before a back track until the end of the tiles array
-	tile_check_loop:for (uint8 idx = stack[current_idx].idx; idx < total_size; idx++)
+	tile_check_loop:for (uint8 pos = stack[current_idx].idx; pos < total_size; pos++)
 	{
 		// If the tile is not used then we can check to see if the tile is valid
+		uint8 idx = candidate(pos);
 		if (!used[idx])
 		{
 			// Perform some check to see if this tile in any rotation fits
 			// If that check passes we want to check the rotation count and the index used and mark the tile used
-			if (check_tile(idx, tiles[idx], 0))
+			if (check_tile(pos, tiles[idx], 0))
 				return 1;
 		}
 	}
 
 	return 0;
 }
+#endif
 
 void backtrack()
 {
 	stack[current_idx].idx = 0;
 	stack[current_idx].rot = 0;
 	dec_current();
-	uint8 idx = stack[current_idx].idx;
+	uint8 pos = stack[current_idx].idx;
+	uint8 idx = candidate(pos);
 	used[idx] = 0;
 	uint3 init_rot = stack[current_idx].rot;
-	uint32 tile = clockwise_rotate(tiles[idx]);
+	tile_word tile = clockwise_rotate(tiles[idx]);
 
 	// We want to check the last successful tile in all other possible rotations to see if it still fits in that position
 	// If it does not then increment the index stored in the stack so we don't check that tile again since we know it is
 	// not valid
 	// We then exit back to the main loop so it can try to get another tile to fit
-	if (!check_tile(idx, tile, init_rot + 1))
+	if (!check_tile(pos, tile, init_rot + 1))
 	{
 		current_grid[current_idx] = 0;
 		stack[current_idx].idx++;
@@ -165,7 +362,7 @@ void backtrack()
 	}
 }
 
-uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot)
+uint1 check_tile(uint8 pos, tile_word tile, uint3 init_rot)
 {
 	// We want to check the tile in all possible rotations
 	rotation_check:for (uint3 rot = init_rot; rot < 4; rot++)
@@ -175,7 +372,7 @@ uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot)
 		// If it's not at the top then check the colour match
 		if (current_y != 0)
 		{
-			valid_top = BOTTOM(current_grid + current_idx - size) == TOP(&tile);
+			valid_top = BOTTOM(current_grid[current_idx - size]) == TOP(tile);
 		}
 		else
 			valid_top = 1;
@@ -183,7 +380,7 @@ uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot)
 		// If it's not at the very left then check the colour match
 		if (current_x != 0)
 		{
-			valid_left= RIGHT(current_grid + current_idx - 1) == LEFT(&tile);
+			valid_left= RIGHT(current_grid[current_idx - 1]) == LEFT(tile);
 		}
 		else
 			valid_left = 1;
@@ -193,12 +390,7 @@ uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot)
 		// Otherwise we try the next rotation
 		if (valid_left && valid_top)
 		{
-			stack[current_idx].idx = idx;
-			stack[current_idx].rot = rot;
-			tiles[idx] = tile;
-			current_grid[current_idx] = tile;
-			used[idx] = 1;
-			inc_current();
+			place_tile(pos, tile, rot);
 			return 1;
 		}
 		else
@@ -207,14 +399,121 @@ uint1 check_tile(uint8 idx, uint32 tile, uint3 init_rot)
 	return 0;
 }
 
-uint32 clockwise_rotate(uint32 tile)
+void shuffle_order(uint16 seed)
+{
+	// A seed of 0 keeps the tiles in the order they are in ram
+	// Otherwise shuffle them with a 16 bit Galois LFSR, each step picks a tile below i with a multiply rather than a modulo
+	uint16 lfsr = seed;
+	order_loop:for (uint8 i = 0; i < MAX_TILES; i++)
+		order[i] = i;
+	if (seed == 0)
+		return;
+	shuffle_loop:for (uint8 i = total_size - 1; i > 0; i--)
+	{
+		lfsr = (lfsr >> 1) ^ ((lfsr & 1) ? 0xB400 : 0);
+		uint8 j = ((uint32)lfsr * (i + 1)) >> 16;
+		uint8 tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+}
+
+uint8 candidate(uint8 pos)
+{
+	// The first position is left in ram order so that start_idx and end_idx mean the same whatever the seed
+	return current_idx == 0 ? pos : order[pos];
+}
+
+uint32 cell_hash(uint8 pos, tile_word tile)
+{
+	// The same as solution_cell_hash() in software/puzzle.h, the colours are packed the same on both sides
+	uint32 h = (TOP(tile) | (BOTTOM(tile) << 8) | (LEFT(tile) << 16) | ((uint32)RIGHT(tile) << 24)) ^ (pos * 0x9E3779B1);
+	h *= 0x85EBCA6B;
+	return h ^ (h >> 13);
+}
+
+uint32 grid_hash()
+{
+	// Hash the grid turned each of the four ways and keep the smallest, so every way round hashes the same
+	// The cells are summed so the order they are visited in does not matter
+	uint32 h[4] = {0, 0, 0, 0};
+	uint8 idx = 0;
+	hash_y:for (uint4 y = 0; y < size; y++)
+	{
+		hash_x:for (uint4 x = 0; x < size; x++)
+		{
+			tile_word tile = current_grid[idx++];
+			h[0] += cell_hash(y * size + x, tile);
+			tile = clockwise_rotate(tile);
+			h[1] += cell_hash(x * size + size - 1 - y, tile);
+			tile = clockwise_rotate(tile);
+			h[2] += cell_hash((size - 1 - y) * size + size - 1 - x, tile);
+			tile = clockwise_rotate(tile);
+			h[3] += cell_hash((size - 1 - x) * size + y, tile);
+		}
+	}
+	uint32 hash = h[0];
+	hash_min:for (uint3 r = 1; r < 4; r++)
+		if (h[r] < hash)
+			hash = h[r];
+	return hash;
+}
+
+uint1 seen_solution(uint32 *filter)
+{
+	uint32 hash = grid_hash();
+	hash_bits:for (uint2 i = 0; i < 3; i++)
+	{
+		uint10 bit = (hash >> (i * 10)) & (SOLUTION_FILTER_BITS - 1);
+		if (!((filter[bit >> 5] >> (bit & 31)) & 1))
+			return 0;
+	}
+
+	// The bits can all be set by other solutions, so only skip it if the hash itself is known
+	uint8 count = filter[SOLUTION_FILTER_COUNT];
+	hash_list:for (uint8 i = 0; i < SOLUTION_FILTER_MAX_HASHES; i++)
+	{
+		if (i == count)
+			break;
+		if (filter[SOLUTION_FILTER_HASHES + i] == hash)
+			return 1;
+	}
+	return 0;
+}
+
+void filter_add(uint32 *filter)
+{
+	// Only used in a batch, otherwise the software keeps the filter
+	uint32 hash = grid_hash();
+	filter_bits:for (uint2 i = 0; i < 3; i++)
+	{
+		uint10 bit = (hash >> (i * 10)) & (SOLUTION_FILTER_BITS - 1);
+		filter[bit >> 5] |= (uint32)1 << (bit & 31);
+	}
+	uint8 count = filter[SOLUTION_FILTER_COUNT];
+	if (count < SOLUTION_FILTER_MAX_HASHES)
+	{
+		filter[SOLUTION_FILTER_HASHES + count] = hash;
+		filter[SOLUTION_FILTER_COUNT] = count + 1;
+	}
+}
+
+void place_tile(uint8 pos, tile_word tile, uint3 rot)
+{
+	// Add the tile to the grid turned the way it fits and move on to the next position
+	uint8 idx = candidate(pos);
+	stack[current_idx].idx = pos;
+	stack[current_idx].rot = rot;
+	tiles[idx] = tile;
+	current_grid[current_idx] = tile;
+	used[idx] = 1;
+	inc_current();
+}
+
+tile_word clockwise_rotate(tile_word tile)
 {
-	uint5 tmp = TOP(&tile);
-	TOP(&tile) = LEFT(&tile);
-	LEFT(&tile) = BOTTOM(&tile);
-	BOTTOM(&tile) = RIGHT(&tile);
-	RIGHT(&tile) = tmp;
-	return tile;
+	// The left edge goes to the top, the bottom to the left, the right to the bottom and the top to the right
+	return MAKE_TILE(LEFT(tile), RIGHT(tile), BOTTOM(tile), TOP(tile));
 }
 
 void inc_current()
@@ -4,6 +4,42 @@
 #include <ap_cint.h>
 
 #define MAX_SIZE 10
-uint1 toplevel(uint32 *ram, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, uint8 *in_end_idx, uint1 *abort);
+
+// What toplevel() returns
+// The search space is finished or it was aborted
+#define TOPLEVEL_DONE 0
+// A solution has been written to ram, start it again without reset to carry on
+#define TOPLEVEL_SOLUTION 1
+// The node budget ran out, start it again without reset to carry on or with reset to restart
+#define TOPLEVEL_BUDGET 2
+
+// The Bloom filter of solutions already found, kept by the software, this must match software/puzzle.h
+// Each solution sets 3 bits picked by 10 bit slices of its hash
+// After the bits is the number of solutions then their hashes, a solution whose bits are all set is only
+// skipped if its hash is in that list so a false positive of the bits never loses a solution
+#define SOLUTION_FILTER_BITS 1024
+#define SOLUTION_FILTER_COUNT (SOLUTION_FILTER_BITS / 32)
+#define SOLUTION_FILTER_HASHES (SOLUTION_FILTER_COUNT + 1)
+#define SOLUTION_FILTER_MAX_HASHES 20
+#define SOLUTION_FILTER_WORDS (SOLUTION_FILTER_HASHES + SOLUTION_FILTER_MAX_HASHES)
+
+// With in_batch set ram is a list of that many puzzles laid out as below, this must match batch_desc_t in software/puzzle.h
+// Each puzzle is searched in full and every solution kept, then the next is started, the core returns once all are done
+// filter is then the core's own, it is cleared and filled in for each puzzle so turned copies are only kept once
+// The size is written by the software, the solution count and flags by the core, all other registers are ignored
+#define BATCH_MAX_SOLUTIONS 20
+#define BATCH_SIZE 0
+#define BATCH_SOLUTIONS 1
+#define BATCH_FLAGS 2
+#define BATCH_TILES 3
+#define BATCH_SOLUTION(n) (BATCH_TILES + MAX_SIZE * MAX_SIZE * ((n) + 1))
+// Each puzzle is rounded up to whole 32 byte cache lines so the software can flush one without touching the next
+#define BATCH_DESC_WORDS ((BATCH_SOLUTION(BATCH_MAX_SOLUTIONS) + 7) & ~7)
+// The flags, BATCH_MAX_SOLUTIONS solutions were found so there may be more, or the search was aborted
+#define BATCH_FULL 0x01
+#define BATCH_ABORTED 0x02
+
+uint2 toplevel(uint32 *ram, uint32 *filter, uint1 *reset, uint4 *in_size, uint8 *in_start_idx, uint8 *in_end_idx,
+		uint1 *abort, uint32 *in_budget, uint16 *in_seed, uint8 *in_batch);
 
 #endif
@@ -0,0 +1,329 @@
+// Stand in for a board in cluster mode
+// Answers a coordinator the same way the firmware does, running the solver core's C source for each job
+//
+// Build from the repository root with:
+//   gcc -O2 -std=gnu99 -Ihost/include -Isoftware -Ihardware -o board_sim host/board_sim.c hardware/toplevel.c -lpthread
+//
+// Usage: board_sim [-p port] [-n cores] [-q queue] [-k jobs]
+// The core keeps its state in globals so there is only one, -n is just the number of cores advertised
+// It runs on its own thread so the network is always answered, as the firmware does between polls of the cores
+// -k exits without a word after that many jobs, to test a coordinator giving the rest to other boards
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "xil_types.h"
+#include "protocol.h"
+#include "toplevel.h"
+
+// Most jobs that can be waiting and most unique solutions kept per job, as on the board
+#define SIM_MAX_QUEUE 16
+#define SIM_MAX_SOLUTIONS 20
+
+// Where the core's ram keeps each edge of a tile
+#define CORE_TOP 0
+#define CORE_BOTTOM 1
+#define CORE_LEFT 2
+#define CORE_RIGHT 3
+
+typedef struct {
+    u32 id;
+    u8 size;
+    u8 start;
+    u8 end;
+    uint32 tiles[MAX_SIZE * MAX_SIZE];
+    struct sockaddr_in from;
+} sim_job_t;
+
+static int sock;
+static sim_job_t queue[SIM_MAX_QUEUE];
+static u32 queue_head;
+static u32 queue_count;
+static u32 queue_size = 4;
+static u32 cores = 4;
+static int kill_after;
+// The queue is shared between the network and the solver thread
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+
+static u32 now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void send_to(struct sockaddr_in *to, void *buf, u32 len)
+{
+    if (sendto(sock, buf, len, 0, (struct sockaddr *)to, sizeof(*to)) < 0)
+        perror("sendto");
+}
+
+static void send_job_done(struct sockaddr_in *to, u32 id, u32 solutions, u8 flags, u32 time)
+{
+    proto_job_done_t done;
+    done.header = JOB_DONE_HEADER;
+    PROTO_PUT_U32(done.id, id);
+    PROTO_PUT_U16(done.solutions, solutions);
+    done.flags = flags;
+    PROTO_PUT_U32(done.time, time);
+    send_to(to, &done, JOB_DONE_LEN);
+}
+
+static void send_job_result(sim_job_t *job, uint32 *grid, u32 index, u32 time)
+{
+    u8 buf[JOB_RESULT_HEADER_LEN + MAX_SIZE * MAX_SIZE * PROTO_TILE_LEN];
+    u32 count = job->size * job->size;
+
+    buf[0] = JOB_RESULT_HEADER;
+    PROTO_PUT_U32(buf + 1, job->id);
+    buf[5] = job->size;
+    buf[6] = index;
+    PROTO_PUT_U32(buf + 7, time);
+    for (u32 i = 0; i < count; i++)
+    {
+        u8 *edges = (u8 *)&grid[i];
+        u8 *out = buf + JOB_RESULT_HEADER_LEN + i * PROTO_TILE_LEN;
+        out[0] = edges[CORE_TOP];
+        out[1] = edges[CORE_RIGHT];
+        out[2] = edges[CORE_BOTTOM];
+        out[3] = edges[CORE_LEFT];
+    }
+    send_to(&job->from, buf, JOB_RESULT_HEADER_LEN + count * PROTO_TILE_LEN);
+}
+
+static void handle_packet(u8 *buf, ssize_t len, struct sockaddr_in *from)
+{
+    switch (buf[0])
+    {
+        case HELLO_HEADER:
+        {
+            proto_advertise_t adv;
+            pthread_mutex_lock(&queue_lock);
+            adv.header = ADVERTISE_HEADER;
+            adv.free = queue_size - queue_count;
+            adv.cores = cores;
+            adv.queued = queue_count;
+            pthread_mutex_unlock(&queue_lock);
+            send_to(from, &adv, ADVERTISE_LEN);
+            break;
+        }
+
+        case JOB_HEADER:
+        {
+            if (len < JOB_HEADER_LEN)
+                break;
+
+            u32 id = PROTO_GET_U32(buf + 1);
+            u8 size = buf[5];
+            pthread_mutex_lock(&queue_lock);
+            if (queue_count == queue_size || size < 2 || size > MAX_SIZE || buf[6] >= buf[7] || buf[7] > size * size ||
+                    len < JOB_HEADER_LEN + PROTO_PUZZLE_LEN(size))
+            {
+                pthread_mutex_unlock(&queue_lock);
+                send_job_done(from, id, 0, JOB_REJECTED, 0);
+                break;
+            }
+
+            sim_job_t *job = &queue[(queue_head + queue_count) % SIM_MAX_QUEUE];
+            job->id = id;
+            job->size = size;
+            job->start = buf[6];
+            job->end = buf[7];
+            job->from = *from;
+            memset(job->tiles, 0, sizeof(job->tiles));
+            for (u32 i = 0; i < size * size; i++)
+            {
+                u8 *in = buf + JOB_HEADER_LEN + i * PROTO_TILE_LEN;
+                u8 *edges = (u8 *)&job->tiles[i];
+                edges[CORE_TOP] = in[0];
+                edges[CORE_RIGHT] = in[1];
+                edges[CORE_BOTTOM] = in[2];
+                edges[CORE_LEFT] = in[3];
+            }
+            queue_count++;
+            pthread_cond_signal(&queue_cond);
+            pthread_mutex_unlock(&queue_lock);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// Returns 1 if b is a turned round by some number of quarters, the firmware counts these as one solution
+static int same_turned(const uint32 *a, const uint32 *b, u8 size)
+{
+    static uint32 turned[MAX_SIZE * MAX_SIZE];
+    static uint32 next[MAX_SIZE * MAX_SIZE];
+    u32 count = size * size;
+
+    memcpy(turned, a, count * sizeof(uint32));
+    for (int r = 0; r < 4; r++)
+    {
+        if (memcmp(turned, b, count * sizeof(uint32)) == 0)
+            return 1;
+
+        // Turn the grid a quarter clockwise, the tile at (x, y) moves to (size - 1 - y, x) and what was on its left goes on top
+        for (u32 y = 0; y < size; y++)
+        {
+            for (u32 x = 0; x < size; x++)
+            {
+                const u8 *in = (const u8 *)&turned[y * size + x];
+                u8 *out = (u8 *)&next[x * size + size - 1 - y];
+                out[CORE_TOP] = in[CORE_LEFT];
+                out[CORE_RIGHT] = in[CORE_TOP];
+                out[CORE_BOTTOM] = in[CORE_RIGHT];
+                out[CORE_LEFT] = in[CORE_BOTTOM];
+            }
+        }
+        memcpy(turned, next, count * sizeof(uint32));
+    }
+    return 0;
+}
+
+// Runs a job to completion the same way solve_puzzle() drives a core, restarting it after every solution
+static void run_job(sim_job_t *job)
+{
+    static uint32 ram[MAX_SIZE * MAX_SIZE];
+    static uint32 solutions[SIM_MAX_SOLUTIONS][MAX_SIZE * MAX_SIZE];
+    u32 count = 0;
+    u8 flags = 0;
+    u32 start = now_us();
+
+    uint1 reset = 1;
+    uint1 abort = 0;
+    uint4 size = job->size;
+    uint8 start_idx = job->start;
+    uint8 end_idx = job->end;
+    uint32 budget = 0;
+    uint16 seed = 0;
+    uint8 batch = 0;
+    // Duplicates are checked here instead, so the core's filter is left empty
+    static uint32 filter[SOLUTION_FILTER_WORDS];
+    memcpy(ram, job->tiles, sizeof(ram));
+
+    while (toplevel(ram, filter, &reset, &size, &start_idx, &end_idx, &abort, &budget, &seed, &batch) == TOPLEVEL_SOLUTION)
+    {
+        reset = 0;
+
+        u32 i;
+        for (i = 0; i < count; i++)
+            if (same_turned(solutions[i], ram, job->size))
+                break;
+        if (i == count)
+        {
+            memcpy(solutions[count], ram, sizeof(ram));
+            count++;
+            send_job_result(job, ram, count, now_us() - start);
+            if (count == SIM_MAX_SOLUTIONS)
+            {
+                flags = SUMMARY_ABORTED | SUMMARY_BUF_FULL;
+                break;
+            }
+        }
+    }
+
+    send_job_done(&job->from, job->id, count, flags, now_us() - start);
+    printf("job %u, tiles %u-%u: %u solutions in %u us\n", job->id, job->start, job->end - 1, count, now_us() - start);
+}
+
+static void *solver_thread(void *arg)
+{
+    // The job stays in the queue while it runs so it is counted when advertising
+    for (int jobs_run = 1; ; jobs_run++)
+    {
+        pthread_mutex_lock(&queue_lock);
+        while (queue_count == 0)
+            pthread_cond_wait(&queue_cond, &queue_lock);
+        sim_job_t *job = &queue[queue_head];
+        pthread_mutex_unlock(&queue_lock);
+
+        run_job(job);
+
+        pthread_mutex_lock(&queue_lock);
+        queue_head = (queue_head + 1) % SIM_MAX_QUEUE;
+        queue_count--;
+        pthread_mutex_unlock(&queue_lock);
+
+        if (kill_after && jobs_run == kill_after)
+        {
+            printf("Stopping after %d jobs\n", jobs_run);
+            exit(0);
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    int port = PROTO_PORT;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:n:q:k:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'n':
+                cores = atoi(optarg);
+                break;
+            case 'q':
+                queue_size = atoi(optarg);
+                break;
+            case 'k':
+                kill_after = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-n cores] [-q queue] [-k jobs]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (queue_size < 1 || queue_size > SIM_MAX_QUEUE)
+    {
+        fprintf(stderr, "queue must be 1-%d\n", SIM_MAX_QUEUE);
+        return 1;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    printf("Board listening on port %d\n", port);
+
+    pthread_t solver;
+    pthread_create(&solver, NULL, solver_thread, NULL);
+
+    u8 buf[2048];
+    for (;;)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (len > 0)
+            handle_packet(buf, len, &from);
+    }
+}
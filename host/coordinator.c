@@ -0,0 +1,379 @@
+// Cluster coordinator
+// Splits one puzzle into jobs over ranges of the tile placed first and hands them to the boards that have room
+// Every board is sent HELLO regularly, a board that stops answering has its jobs given to the others
+//
+// Build from the repository root with:
+//   gcc -O2 -std=gnu99 -Ihost/include -Isoftware -Ihost -o coordinator host/coordinator.c host/puzzle_gen.c
+//
+// Usage: coordinator -b host[:port] [-b host[:port] ...] [-s size] [-S seed] [-c colours] [-j jobs] [-t timeout_ms] [-v]
+// The puzzle is made with puzzle_gen.c from size and seed and every solution that comes back is checked
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "puzzle_gen.h"
+
+// The boards take at most 10x10 and the range of first tiles is sent as bytes
+#define COORD_MAX_SIZE 10
+#define COORD_MAX_TILES (COORD_MAX_SIZE * COORD_MAX_SIZE)
+#define MAX_BOARDS 32
+// Unique solutions that are kept to spot repeats, any more are still counted
+#define MAX_SOLUTIONS 1024
+// How often every board is sent HELLO
+#define HELLO_INTERVAL_MS 200
+
+#define JOB_PENDING 0
+#define JOB_ASSIGNED 1
+#define JOB_DONE 2
+
+typedef struct {
+    struct sockaddr_in addr;
+    u8 alive;
+    u32 free;           // Jobs the board said it could take, less the ones sent since
+    u32 cores;
+    u32 last_seen_ms;
+    u32 jobs_done;
+    u32 jobs_lost;
+    u32 solutions;
+} board_t;
+
+typedef struct {
+    u8 start;
+    u8 end;
+    u8 state;
+    int board;
+    u32 id;             // Changes every time the job is sent so answers to an earlier send can be told apart
+    u32 issues;
+} coord_job_t;
+
+static int sock;
+static board_t boards[MAX_BOARDS];
+static int board_count;
+static coord_job_t jobs[COORD_MAX_TILES];
+static int job_count;
+static u8 size = 4;
+static u32 seed;
+static u32 colours = GEN_DEFAULT_COLOURS;
+static u8 tiles[COORD_MAX_TILES * PROTO_TILE_LEN];
+static u8 solutions[MAX_SOLUTIONS][COORD_MAX_TILES * PROTO_TILE_LEN];
+static u32 solution_count;
+static u32 bad_results;
+static u8 incomplete;
+static int verbose;
+
+static u32 now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int parse_board(const char *arg, struct sockaddr_in *addr)
+{
+    char host[256];
+    int port = PROTO_PORT;
+    const char *colon = strchr(arg, ':');
+    size_t len = colon ? (size_t)(colon - arg) : strlen(arg);
+    if (len >= sizeof(host))
+        return 0;
+    memcpy(host, arg, len);
+    host[len] = '\0';
+    if (colon)
+        port = atoi(colon + 1);
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    return inet_aton(host, &addr->sin_addr);
+}
+
+static int find_board(struct sockaddr_in *from)
+{
+    for (int i = 0; i < board_count; i++)
+        if (boards[i].addr.sin_addr.s_addr == from->sin_addr.s_addr && boards[i].addr.sin_port == from->sin_port)
+            return i;
+    return -1;
+}
+
+static const char *board_name(int b)
+{
+    static char name[32];
+    snprintf(name, sizeof(name), "%s:%u", inet_ntoa(boards[b].addr.sin_addr), ntohs(boards[b].addr.sin_port));
+    return name;
+}
+
+static void send_to(struct sockaddr_in *to, void *buf, u32 len)
+{
+    if (sendto(sock, buf, len, 0, (struct sockaddr *)to, sizeof(*to)) < 0)
+        perror("sendto");
+}
+
+static void send_job(int j, int b)
+{
+    u8 buf[JOB_HEADER_LEN + COORD_MAX_TILES * PROTO_TILE_LEN];
+    coord_job_t *job = &jobs[j];
+
+    // The job index is in the bottom 16 bits, the number of times it has been sent above that
+    job->issues++;
+    job->id = (job->issues << 16) | j;
+    job->state = JOB_ASSIGNED;
+    job->board = b;
+
+    buf[0] = JOB_HEADER;
+    PROTO_PUT_U32(buf + 1, job->id);
+    buf[5] = size;
+    buf[6] = job->start;
+    buf[7] = job->end;
+    memcpy(buf + JOB_HEADER_LEN, tiles, PROTO_PUZZLE_LEN(size));
+    send_to(&boards[b].addr, buf, JOB_HEADER_LEN + PROTO_PUZZLE_LEN(size));
+
+    if (verbose)
+        printf("job %d (tiles %u-%u) -> %s\n", j, job->start, job->end - 1, board_name(b));
+}
+
+static void assign_jobs()
+{
+    // Give each waiting job to the board with the most room, so work spreads across the boards
+    for (int j = 0; j < job_count; j++)
+    {
+        if (jobs[j].state != JOB_PENDING)
+            continue;
+
+        int best = -1;
+        for (int b = 0; b < board_count; b++)
+            if (boards[b].alive && boards[b].free > 0 && (best < 0 || boards[b].free > boards[best].free))
+                best = b;
+        if (best < 0)
+            return;
+
+        boards[best].free--;
+        send_job(j, best);
+    }
+}
+
+static void lose_board(int b)
+{
+    // Everything the board had is given to the others, answers that still turn up from it are ignored
+    boards[b].alive = 0;
+    boards[b].free = 0;
+    for (int j = 0; j < job_count; j++)
+    {
+        if (jobs[j].state == JOB_ASSIGNED && jobs[j].board == b)
+        {
+            jobs[j].state = JOB_PENDING;
+            boards[b].jobs_lost++;
+        }
+    }
+    printf("%s stopped responding\n", board_name(b));
+}
+
+static void handle_result(int b, u8 *buf, ssize_t len)
+{
+    if (len < JOB_RESULT_HEADER_LEN + PROTO_PUZZLE_LEN(size) || buf[5] != size)
+        return;
+
+    // Results from an earlier send of a job are still good solutions so are not checked against the job id
+    u8 *tiles = buf + JOB_RESULT_HEADER_LEN;
+    int err = gen_verify(size, seed, colours, tiles);
+    if (err != GEN_OK)
+    {
+        bad_results++;
+        printf("%s: bad solution for job %u: %s\n", board_name(b), PROTO_GET_U32(buf + 1) & 0xFFFF, gen_error(err));
+        return;
+    }
+
+    // Jobs given out twice can find the same solution twice, and turned copies are counted once as the firmware does
+    u32 kept = solution_count < MAX_SOLUTIONS ? solution_count : MAX_SOLUTIONS;
+    for (u32 i = 0; i < kept; i++)
+        if (gen_same_solution(size, solutions[i], tiles))
+            return;
+
+    if (solution_count < MAX_SOLUTIONS)
+        memcpy(solutions[solution_count], tiles, PROTO_PUZZLE_LEN(size));
+    solution_count++;
+    boards[b].solutions++;
+    if (verbose)
+        printf("%s: solution %u after %u us\n", board_name(b), solution_count, PROTO_GET_U32(buf + 7));
+}
+
+static void handle_done(int b, u8 *buf, ssize_t len)
+{
+    if (len < JOB_DONE_LEN)
+        return;
+
+    u32 id = PROTO_GET_U32(buf + 1);
+    u32 j = id & 0xFFFF;
+    u8 flags = buf[7];
+    if (j >= job_count || jobs[j].id != id || jobs[j].state != JOB_ASSIGNED)
+        return;
+
+    // Rejected jobs and ones stopped from the board's console still have search space left so go to another board
+    // A full solution buffer also stops a job but sending it again would just find the same solutions
+    if ((flags & JOB_REJECTED) || ((flags & SUMMARY_ABORTED) && !(flags & SUMMARY_BUF_FULL)))
+    {
+        jobs[j].state = JOB_PENDING;
+        return;
+    }
+
+    if (flags & SUMMARY_BUF_FULL)
+        incomplete = 1;
+    // Every job has all the tiles, so a board finding the puzzle can't be solved means none of the jobs can be
+    if (flags & SUMMARY_INFEASIBLE)
+    {
+        for (int k = 0; k < job_count; k++)
+            jobs[k].state = JOB_DONE;
+        printf("%s: the puzzle has no solution, its edge colours can't pair up\n", board_name(b));
+    }
+    jobs[j].state = JOB_DONE;
+    boards[b].jobs_done++;
+    if (verbose)
+        printf("%s: job %u done, %u solutions in %u us\n", board_name(b), j, PROTO_GET_U16(buf + 5), PROTO_GET_U32(buf + 8));
+}
+
+int main(int argc, char **argv)
+{
+    int job_target = 0;
+    u32 timeout_ms = 3000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:s:S:c:j:t:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'b':
+                if (board_count == MAX_BOARDS || !parse_board(optarg, &boards[board_count].addr))
+                {
+                    fprintf(stderr, "bad or too many boards: %s\n", optarg);
+                    return 1;
+                }
+                board_count++;
+                break;
+            case 's':
+                size = atoi(optarg);
+                break;
+            case 'S':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                colours = atoi(optarg);
+                break;
+            case 'j':
+                job_target = atoi(optarg);
+                break;
+            case 't':
+                timeout_ms = atoi(optarg);
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s -b host[:port] [-b ...] [-s size] [-S seed] [-c colours] [-j jobs] [-t timeout_ms] [-v]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (board_count == 0 || size < 2 || size > COORD_MAX_SIZE || colours < 1 || colours > GEN_MAX_COLOURS)
+    {
+        fprintf(stderr, "need at least one board, size 2-%d and colours 1-%d\n", COORD_MAX_SIZE, GEN_MAX_COLOURS);
+        return 1;
+    }
+
+    // By default every first tile is its own job, which gives the finest grained balancing
+    u32 tile_count = size * size;
+    if (job_target < 1 || job_target > tile_count)
+        job_target = tile_count;
+    job_count = job_target;
+    for (int j = 0; j < job_count; j++)
+    {
+        jobs[j].start = (j * tile_count) / job_count;
+        jobs[j].end = ((j + 1) * tile_count) / job_count;
+    }
+
+    gen_puzzle(size, seed, colours, tiles, NULL);
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    printf("Solving size %u seed %u as %d jobs over %d boards\n", size, seed, job_count, board_count);
+
+    u32 start_ms = now_ms();
+    u32 hello_ms = 0;
+    for (;;)
+    {
+        int finished = 1;
+        for (int j = 0; j < job_count; j++)
+            if (jobs[j].state != JOB_DONE)
+                finished = 0;
+        if (finished)
+            break;
+
+        u32 now = now_ms();
+        if (now - hello_ms >= HELLO_INTERVAL_MS || hello_ms == 0)
+        {
+            u8 hello = HELLO_HEADER;
+            for (int b = 0; b < board_count; b++)
+            {
+                send_to(&boards[b].addr, &hello, HELLO_LEN);
+                if (boards[b].alive && now - boards[b].last_seen_ms > timeout_ms)
+                    lose_board(b);
+            }
+            hello_ms = now;
+        }
+
+        struct pollfd pfd = { .fd = sock, .events = POLLIN };
+        if (poll(&pfd, 1, HELLO_INTERVAL_MS / 4) <= 0)
+            continue;
+
+        u8 buf[2048];
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        int b = len > 0 ? find_board(&from) : -1;
+        if (b < 0)
+            continue;
+
+        // Anything from a board shows it is still there
+        if (!boards[b].alive)
+            printf("%s is up\n", board_name(b));
+        boards[b].alive = 1;
+        boards[b].last_seen_ms = now_ms();
+
+        switch (buf[0])
+        {
+            case ADVERTISE_HEADER:
+                if (len < ADVERTISE_LEN)
+                    break;
+                boards[b].free = buf[1];
+                boards[b].cores = buf[2];
+                break;
+            case JOB_RESULT_HEADER:
+                handle_result(b, buf, len);
+                break;
+            case JOB_DONE_HEADER:
+                handle_done(b, buf, len);
+                break;
+            default:
+                break;
+        }
+
+        assign_jobs();
+    }
+
+    printf("%u unique solutions%s in %u ms, %u bad results\n", solution_count,
+        incomplete ? " (some jobs hit the solution limit)" : "", now_ms() - start_ms, bad_results);
+    for (int b = 0; b < board_count; b++)
+        printf("  %-21s %u cores, %u jobs, %u lost, %u solutions\n", board_name(b), boards[b].cores,
+            boards[b].jobs_done, boards[b].jobs_lost, boards[b].solutions);
+
+    return bad_results ? 2 : 0;
+}
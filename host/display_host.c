@@ -0,0 +1,103 @@
+// Host display backend
+// Renders into a plain buffer in memory so the renderer can be run and checked on Linux
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "display_host.h"
+
+// Backend state kept behind display_t.priv
+typedef struct {
+    u32 *frame;
+    u32 flushes;
+} host_display_t;
+
+int display_init(display_t *disp, const VideoMode *mode)
+{
+    host_display_t *host = calloc(1, sizeof(host_display_t));
+    if (!host)
+        return XST_FAILURE;
+
+    // Frames are packed, so the stride is just the width
+    host->frame = calloc((size_t)mode->width * mode->height, sizeof(u32));
+    if (!host->frame)
+    {
+        free(host);
+        return XST_FAILURE;
+    }
+
+    disp->mode = *mode;
+    disp->surface.frame = host->frame;
+    disp->surface.stride = mode->width;
+    disp->surface.width = mode->width;
+    disp->surface.height = mode->height;
+    disp->priv = host;
+
+    return XST_SUCCESS;
+}
+
+void display_flush(display_t *disp)
+{
+    // There is no cache to flush, just keep count so tests can check frames were presented
+    ((host_display_t *)disp->priv)->flushes++;
+}
+
+void display_free(display_t *disp)
+{
+    host_display_t *host = disp->priv;
+    free(host->frame);
+    free(host);
+    disp->priv = NULL;
+    disp->surface.frame = NULL;
+}
+
+u32 display_flush_count(display_t *disp)
+{
+    return ((host_display_t *)disp->priv)->flushes;
+}
+
+int display_write_ppm(display_t *disp, const char *path)
+{
+    surface_t *s = &disp->surface;
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return XST_FAILURE;
+
+    // Binary PPM, one RGB triple per pixel
+    fprintf(f, "P6\n%u %u\n255\n", s->width, s->height);
+    for (u32 y = 0; y < s->height; y++)
+    {
+        for (u32 x = 0; x < s->width; x++)
+        {
+            u32 pixel = s->frame[y * s->stride + x];
+            u8 rgb[3] = {
+                (pixel >> PIXEL_BIT_RED) & 0xFF,
+                (pixel >> PIXEL_BIT_GREEN) & 0xFF,
+                (pixel >> PIXEL_BIT_BLUE) & 0xFF
+            };
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+
+    return fclose(f) == 0 ? XST_SUCCESS : XST_FAILURE;
+}
+
+u32 display_checksum(display_t *disp)
+{
+    surface_t *s = &disp->surface;
+    u32 hash = 2166136261u;
+    for (u32 y = 0; y < s->height; y++)
+    {
+        for (u32 x = 0; x < s->width; x++)
+        {
+            u32 pixel = s->frame[y * s->stride + x];
+            u8 rgb[3] = {
+                (pixel >> PIXEL_BIT_RED) & 0xFF,
+                (pixel >> PIXEL_BIT_GREEN) & 0xFF,
+                (pixel >> PIXEL_BIT_BLUE) & 0xFF
+            };
+            for (int i = 0; i < 3; i++)
+                hash = (hash ^ rgb[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
@@ -0,0 +1,12 @@
+#ifndef __DISPLAY_HOST_H_
+#define __DISPLAY_HOST_H_
+
+#include "display.h"
+
+void display_free(display_t *disp);
+u32 display_flush_count(display_t *disp);
+int display_write_ppm(display_t *disp, const char *path);
+// FNV-1a hash of the frame as the RGB bytes display_write_ppm() writes, for checking frames against known good ones
+u32 display_checksum(display_t *disp);
+
+#endif
@@ -0,0 +1,59 @@
+// Generates software/zybo_z7_hdmi/clk_table.h
+// Runs the ClkFindParams search once for every mode in vga_modes.h so the firmware only has to look the result up
+//
+// Build and run from the repository root with:
+//   gcc -O2 -std=gnu99 -Ihost/include -Isoftware/zybo_z7_hdmi -o gen_clk_table host/gen_clk_table.c software/zybo_z7_hdmi/dynclk.c -lm
+//   ./gen_clk_table > software/zybo_z7_hdmi/clk_table.h
+
+#include <stdio.h>
+#include "dynclk.h"
+#include "vga_modes.h"
+
+static const VideoMode *modes[] = {
+    &VMODE_640x480,
+    &VMODE_800x600,
+    &VMODE_1280x1024,
+    &VMODE_1280x720,
+    &VMODE_1280x800,
+    &VMODE_1440x900,
+    &VMODE_1680x1050
+};
+#define MODE_COUNT (sizeof(modes) / sizeof(modes[0]))
+
+int main()
+{
+    printf("/*\n");
+    printf(" * clk_table.h -- Precomputed axi_dynclk settings for the modes in vga_modes.h\n");
+    printf(" *\n");
+    printf(" * Generated by host/gen_clk_table.c, do not edit by hand.\n");
+    printf(" * Regenerate whenever a mode is added to vga_modes.h or the search in dynclk.c changes.\n");
+    printf(" */\n\n");
+    printf("#ifndef CLK_TABLE_H_\n#define CLK_TABLE_H_\n\n");
+    printf("#include \"dynclk.h\"\n\n");
+    printf("static const ClkTableEntry clk_table[] = {\n");
+
+    for (int i = 0; i < MODE_COUNT; i++)
+    {
+        ClkMode mode;
+        ClkConfig reg;
+
+        ClkFindParams(modes[i]->freq, &mode);
+        if (!ClkFindReg(&reg, &mode))
+        {
+            fprintf(stderr, "no register values for %s\n", modes[i]->label);
+            return 1;
+        }
+
+        printf("\t/* %s */\n", modes[i]->label);
+        printf("\t{ %.17g,\n", modes[i]->freq);
+        printf("\t\t{ %.17g, %u, %u, %u },\n", mode.freq, mode.fbmult, mode.clkdiv, mode.maindiv);
+        printf("\t\t{ 0x%08X, 0x%08X, 0x%08X, 0x%08X, 0x%08X, 0x%08X } }%s\n",
+                reg.clk0L, reg.clkFBL, reg.clkFBH_clk0H, reg.divclk, reg.lockL, reg.fltr_lockH,
+                i == MODE_COUNT - 1 ? "" : ",");
+    }
+
+    printf("};\n\n");
+    printf("#define CLK_TABLE_SIZE (sizeof(clk_table) / sizeof(clk_table[0]))\n\n");
+    printf("#endif /* CLK_TABLE_H_ */\n");
+    return 0;
+}
@@ -0,0 +1,403 @@
+// Linux implementation of the board specific parts of the firmware
+// software/main.c runs as a process with each solver core a thread running the core's C source,
+// the console on stdin and the network on a UDP socket, so the whole pipeline can be profiled with perf
+//
+// Build from the repository root with:
+//   gcc -O2 -std=gnu99 '-DCORE_STATE=static __thread' -Ihost/include -Isoftware -Ihardware -Ihost -o firmware software/main.c software/job_queue.c software/net_config.c software/request_table.c software/stats.c software/sw_solver.c software/render.c host/display_host.c host/hal_linux.c hardware/toplevel.c -lpthread
+//
+// The board's default settings are used, so point it at a server from the console first, for example:
+//   ./puzzle_server -p 51051 -r 0 &
+//   (echo ":server 127.0.0.1:51051"; echo 4; echo 1; echo 8; sleep 5) | ./firmware
+// It listens on PROTO_PORT, or on HAL_PORT from the environment so several can run on one host
+// There is a core for each CPU, or HAL_CORES from the environment
+// Once stdin is closed the console is quiet but the process keeps going, so it can still take jobs from a coordinator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "xil_printf.h"
+#include "platform.h"
+#include "net.h"
+#include "hal.h"
+#include "toplevel.h"
+
+// A solver core, the registers are only written while it is idle as on the board
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32 *ram;
+    uint32 *filter;
+    uint1 reset;
+    uint4 size;
+    uint8 start_idx;
+    uint8 end_idx;
+    volatile uint1 abort;
+    uint32 budget;
+    uint16 seed;
+    uint8 batch;
+    u8 start;
+    u8 done;
+    u8 result;
+    u8 created;
+} linux_core_t;
+
+static linux_core_t cores[HAL_MAX_CORES];
+
+net_stats_t net_stats;
+
+static int sock = -1;
+static udp_recv_fn net_recv_handler;
+
+// A byte read by hal_console_ready() that hal_console_read() has not returned yet
+static int console_pending = -1;
+static u8 console_closed;
+static struct termios console_saved;
+static u8 console_raw;
+
+static struct timespec start_time;
+
+//********************************************************************************
+// Solver cores
+
+static void *core_thread(void *arg)
+{
+    linux_core_t *core = arg;
+
+    pthread_mutex_lock(&core->lock);
+    while (1)
+    {
+        while (!core->start)
+            pthread_cond_wait(&core->cond, &core->lock);
+        core->start = 0;
+        pthread_mutex_unlock(&core->lock);
+
+        // The core's state is thread local so each thread searches on its own
+        u8 result = toplevel(core->ram, core->filter, &core->reset, &core->size, &core->start_idx, &core->end_idx,
+            (uint1 *)&core->abort, &core->budget, &core->seed, &core->batch);
+
+        pthread_mutex_lock(&core->lock);
+        core->result = result;
+        core->done = 1;
+    }
+    return NULL;
+}
+
+u32 hal_core_count()
+{
+    // One core per CPU unless HAL_CORES is set in the environment, 0 leaves everything to the software solver
+    const char *env = getenv("HAL_CORES");
+    long count = env ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 0)
+        count = 0;
+    return count < HAL_MAX_CORES ? count : HAL_MAX_CORES;
+}
+
+int hal_core_init(u32 core, tile_t *ram, u32 *filter)
+{
+    if (core >= HAL_MAX_CORES)
+        return XST_FAILURE;
+
+    linux_core_t *c = &cores[core];
+    c->ram = (uint32 *)ram;
+    c->filter = filter;
+    c->batch = 0;
+    if (c->created)
+        return XST_SUCCESS;
+
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->cond, NULL);
+    if (pthread_create(&c->thread, NULL, core_thread, c) != 0)
+        return XST_FAILURE;
+    c->created = 1;
+    return XST_SUCCESS;
+}
+
+void hal_core_set_reset(u32 core, u8 reset)
+{
+    cores[core].reset = reset;
+}
+
+void hal_core_setup(u32 core, u8 size, u8 start_idx, u8 end_idx)
+{
+    cores[core].size = size;
+    cores[core].start_idx = start_idx;
+    cores[core].end_idx = end_idx;
+}
+
+void hal_core_set_batch(u32 core, batch_desc_t *descs, u32 *filter, u8 count)
+{
+    cores[core].ram = (uint32 *)descs;
+    cores[core].filter = filter;
+    cores[core].batch = count;
+}
+
+void hal_core_set_abort(u32 core, u8 abort)
+{
+    cores[core].abort = abort;
+}
+
+void hal_core_set_search(u32 core, u32 budget, u16 seed)
+{
+    cores[core].budget = budget;
+    cores[core].seed = seed;
+}
+
+void hal_core_start(u32 core)
+{
+    linux_core_t *c = &cores[core];
+    pthread_mutex_lock(&c->lock);
+    c->done = 0;
+    c->start = 1;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+}
+
+u8 hal_core_done(u32 core)
+{
+    linux_core_t *c = &cores[core];
+    pthread_mutex_lock(&c->lock);
+    u8 done = c->done;
+    pthread_mutex_unlock(&c->lock);
+    return done;
+}
+
+u8 hal_core_result(u32 core)
+{
+    return cores[core].result;
+}
+
+// The cores share memory with the process so there is nothing to keep coherent, the locks order the accesses
+void hal_cache_flush(void *addr, u32 len)
+{
+}
+
+void hal_cache_invalidate(void *addr, u32 len)
+{
+}
+
+//********************************************************************************
+// Console
+
+static void console_restore()
+{
+    if (console_raw)
+        tcsetattr(STDIN_FILENO, TCSANOW, &console_saved);
+}
+
+static void on_signal(int sig)
+{
+    console_restore();
+    _exit(0);
+}
+
+static void console_init()
+{
+    // On a terminal take keys as they are pressed without echoing them, as the UART does
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &console_saved) == 0)
+    {
+        struct termios raw = console_saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        console_raw = 1;
+        atexit(console_restore);
+        signal(SIGINT, on_signal);
+        signal(SIGTERM, on_signal);
+    }
+}
+
+u8 hal_console_ready()
+{
+    if (console_pending >= 0)
+        return 1;
+    if (console_closed)
+        return 0;
+
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (poll(&pfd, 1, 0) <= 0)
+        return 0;
+
+    char c;
+    if (read(STDIN_FILENO, &c, 1) != 1)
+    {
+        console_closed = 1;
+        return 0;
+    }
+    // The firmware expects the carriage return a serial terminal sends
+    console_pending = c == '\n' ? '\r' : (u8)c;
+    return 1;
+}
+
+char hal_console_read()
+{
+    while (!hal_console_ready())
+        usleep(1000);
+    char c = console_pending;
+    console_pending = -1;
+    return c;
+}
+
+void hal_console_write(char c)
+{
+    putchar(c);
+    fflush(stdout);
+}
+
+//********************************************************************************
+// Timer, the same interface as software/platform.c
+
+void init_timer()
+{
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    console_init();
+}
+
+static u64 elapsed_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)(now.tv_sec - start_time.tv_sec) * 1000000 + (now.tv_nsec - start_time.tv_nsec) / 1000;
+}
+
+u32 platform_time_us()
+{
+    return elapsed_us();
+}
+
+u32 platform_ticks()
+{
+    return elapsed_us() / (PLATFORM_TICK_MS * 1000);
+}
+
+//********************************************************************************
+// Network, the same interfaces as software/platform.c and software/net.c
+// The host's own address is used so the address settings are only printed
+
+int init_platform(unsigned char *mac_ethernet_address, ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw, int use_dhcp)
+{
+    return 0;
+}
+
+void platform_set_static(ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw)
+{
+    xil_printf("Using the host's address\r\n");
+}
+
+void platform_start_dhcp()
+{
+    xil_printf("Using the host's address\r\n");
+}
+
+int platform_net_ready()
+{
+    return sock >= 0;
+}
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset)
+{
+    u16_t copied = 0;
+    for (; p && copied < len; p = p->next)
+    {
+        if (offset >= p->len)
+        {
+            offset -= p->len;
+            continue;
+        }
+        u16_t n = p->len - offset < len - copied ? p->len - offset : len - copied;
+        memcpy((u8 *)dataptr + copied, (u8 *)p->payload + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+u8_t pbuf_free(struct pbuf *p)
+{
+    // The one receive buffer is reused for every datagram
+    return 1;
+}
+
+int net_init(udp_recv_fn recv)
+{
+    const char *port_env = getenv("HAL_PORT");
+    int port = port_env ? atoi(port_env) : PROTO_PORT;
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        perror("socket");
+        return XST_FAILURE;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        close(sock);
+        sock = -1;
+        return XST_FAILURE;
+    }
+
+    net_recv_handler = recv;
+    xil_printf("Listening on port %d\r\n", port);
+    return XST_SUCCESS;
+}
+
+int net_send(const ip_addr_t *ip, u16 port, const void *payload, u16 len)
+{
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = ip->addr;
+    to.sin_port = htons(port);
+
+    if (sock < 0 || sendto(sock, payload, len, 0, (struct sockaddr *)&to, sizeof(to)) < 0)
+    {
+        net_stats.tx_dropped++;
+        return ERR_MEM;
+    }
+
+    net_stats.tx_packets++;
+    return ERR_OK;
+}
+
+void net_poll()
+{
+    // Hand every datagram that is waiting to the firmware, as handle_ethernet() does on the board
+    static u8 buf[2048];
+    if (sock < 0)
+        return;
+
+    while (1)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), MSG_DONTWAIT, (struct sockaddr *)&from, &from_len);
+        if (len < 0)
+            return;
+
+        struct pbuf p = { .next = NULL, .payload = buf, .tot_len = len, .len = len, .ref = 1 };
+        ip_addr_t addr = { .addr = from.sin_addr.s_addr };
+        net_stats.rx_packets++;
+        net_recv_handler(NULL, NULL, &p, &addr, ntohs(from.sin_port));
+    }
+}
+
+void handle_ethernet()
+{
+    net_poll();
+}
@@ -0,0 +1,22 @@
+#ifndef AP_CINT_H
+#define AP_CINT_H
+
+// Host stand-in for the Vivado HLS header of the same name so hardware/toplevel.c builds as plain C
+// Each type is the smallest standard type that holds it, values are not wrapped to the declared width
+
+#include <stdint.h>
+
+typedef uint8_t uint1;
+typedef uint8_t uint2;
+typedef uint8_t uint3;
+typedef uint8_t uint4;
+typedef uint8_t uint5;
+typedef uint8_t uint6;
+typedef uint8_t uint7;
+typedef uint8_t uint8;
+typedef uint16_t uint10;
+typedef uint16_t uint16;
+typedef uint32_t uint20;
+typedef uint32_t uint32;
+
+#endif
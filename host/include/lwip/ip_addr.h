@@ -0,0 +1,27 @@
+#ifndef LWIP_HDR_IP_ADDR_H
+#define LWIP_HDR_IP_ADDR_H
+
+// Host stand-in for the lwIP header of the same name
+// Only IPv4 addresses and the macros used by the shared firmware sources are provided
+
+#include <arpa/inet.h>
+#include "xil_types.h"
+
+typedef u8 u8_t;
+typedef u16 u16_t;
+typedef u32 u32_t;
+typedef s8 err_t;
+
+// As in lwIP the address is kept in network byte order
+typedef struct {
+    u32_t addr;
+} ip_addr_t;
+
+#define IP4_ADDR(ip, a, b, c, d) ((ip)->addr = htonl(((u32)(a) << 24) | ((u32)(b) << 16) | ((u32)(c) << 8) | (u32)(d)))
+#define ip4_addr1(ip) (((const u8_t *)&(ip)->addr)[0])
+#define ip4_addr2(ip) (((const u8_t *)&(ip)->addr)[1])
+#define ip4_addr3(ip) (((const u8_t *)&(ip)->addr)[2])
+#define ip4_addr4(ip) (((const u8_t *)&(ip)->addr)[3])
+#define ip_addr_copy(dest, src) ((dest).addr = (src).addr)
+
+#endif
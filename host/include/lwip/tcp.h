@@ -0,0 +1,8 @@
+#ifndef LWIP_HDR_TCP_H
+#define LWIP_HDR_TCP_H
+
+// Host stand-in for the lwIP header of the same name, platform.h includes it but nothing from it is used
+
+#include "lwip/udp.h"
+
+#endif
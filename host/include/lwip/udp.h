@@ -0,0 +1,27 @@
+#ifndef LWIP_HDR_UDP_H
+#define LWIP_HDR_UDP_H
+
+// Host stand-in for the lwIP header of the same name
+// host/hal_linux.c hands each datagram to the receive callback as a single pbuf
+
+#include "lwip/ip_addr.h"
+
+#define ERR_OK 0
+#define ERR_MEM -1
+
+struct pbuf {
+    struct pbuf *next;
+    void *payload;
+    u16_t tot_len;
+    u16_t len;
+    u16_t ref;
+};
+
+struct udp_pcb;
+
+typedef void (*udp_recv_fn)(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
+
+u16_t pbuf_copy_partial(const struct pbuf *p, void *dataptr, u16_t len, u16_t offset);
+u8_t pbuf_free(struct pbuf *p);
+
+#endif
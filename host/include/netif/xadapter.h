@@ -0,0 +1,8 @@
+#ifndef __XADAPTER_H_
+#define __XADAPTER_H_
+
+// Host stand-in for the Xilinx lwIP adapter header, platform.h includes it but nothing from it is used
+
+#include "lwip/ip_addr.h"
+
+#endif
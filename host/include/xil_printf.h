@@ -0,0 +1,12 @@
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+// Host stand-in for the Xilinx BSP header of the same name
+// The firmware only uses formats that printf also takes, output is flushed at once as the console prompts have no newline
+
+#include <stdio.h>
+
+#define xil_printf(...) do { printf(__VA_ARGS__); fflush(stdout); } while (0)
+#define print(s) xil_printf("%s", s)
+
+#endif
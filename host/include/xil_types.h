@@ -0,0 +1,22 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+
+// Host stand-in for the Xilinx BSP header of the same name
+// Only the types and status codes used by the shared firmware sources are provided
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef uintptr_t UINTPTR;
+
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+
+#endif
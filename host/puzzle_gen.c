@@ -0,0 +1,179 @@
+#include <string.h>
+#include "puzzle_gen.h"
+
+#define EDGE(tiles, i, e) ((tiles)[(i) * 4 + (e)])
+
+// xorshift32, small and the same on every platform so puzzles can be regenerated anywhere
+static u32 gen_next(u32 *state)
+{
+    u32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static u32 gen_state(u8 size, u32 seed)
+{
+    // Mix the size in so the same seed gives unrelated puzzles at different sizes, the state must not be 0
+    u32 state = seed ^ (size * 0x9E3779B9u);
+    if (state == 0)
+        state = 0x12345678;
+    // Throw away the first few values as they are poorly mixed for small seeds
+    for (int i = 0; i < 8; i++)
+        gen_next(&state);
+    return state;
+}
+
+// Turns a tile a quarter clockwise, what was on the left ends up on the top
+static void gen_rotate(u8 *tile)
+{
+    u8 tmp = tile[GEN_LEFT];
+    tile[GEN_LEFT] = tile[GEN_BOTTOM];
+    tile[GEN_BOTTOM] = tile[GEN_RIGHT];
+    tile[GEN_RIGHT] = tile[GEN_TOP];
+    tile[GEN_TOP] = tmp;
+}
+
+void gen_puzzle(u8 size, u32 seed, u32 colours, u8 *tiles, u8 *solved)
+{
+    u8 grid[GEN_MAX_SIZE * GEN_MAX_SIZE * 4];
+    u32 count = size * size;
+    u32 state = gen_state(size, seed);
+
+    if (colours < 1 || colours > GEN_MAX_COLOURS)
+        colours = GEN_DEFAULT_COLOURS;
+
+    // Lay out a solved grid, every edge shared with a neighbour is copied from it so the grid is always valid
+    for (u32 y = 0; y < size; y++)
+    {
+        for (u32 x = 0; x < size; x++)
+        {
+            u32 i = y * size + x;
+            EDGE(grid, i, GEN_TOP) = y ? EDGE(grid, i - size, GEN_BOTTOM) : gen_next(&state) % colours;
+            EDGE(grid, i, GEN_LEFT) = x ? EDGE(grid, i - 1, GEN_RIGHT) : gen_next(&state) % colours;
+            EDGE(grid, i, GEN_RIGHT) = gen_next(&state) % colours;
+            EDGE(grid, i, GEN_BOTTOM) = gen_next(&state) % colours;
+        }
+    }
+
+    if (solved)
+        memcpy(solved, grid, count * 4);
+
+    // Shuffle the tiles then give each one a random rotation
+    for (u32 i = count - 1; i > 0; i--)
+    {
+        u32 j = gen_next(&state) % (i + 1);
+        u8 tmp[4];
+        memcpy(tmp, &grid[i * 4], 4);
+        memcpy(&grid[i * 4], &grid[j * 4], 4);
+        memcpy(&grid[j * 4], tmp, 4);
+    }
+    for (u32 i = 0; i < count; i++)
+    {
+        u32 rot = gen_next(&state) % 4;
+        for (u32 r = 0; r < rot; r++)
+            gen_rotate(&grid[i * 4]);
+    }
+
+    memcpy(tiles, grid, count * 4);
+}
+
+int gen_verify(u8 size, u32 seed, u32 colours, const u8 *solution)
+{
+    u8 tiles[GEN_MAX_SIZE * GEN_MAX_SIZE * 4];
+    u8 used[GEN_MAX_SIZE * GEN_MAX_SIZE];
+
+    if (size < 2 || size > GEN_MAX_SIZE)
+        return GEN_ERR_SIZE;
+
+    u32 count = size * size;
+    gen_puzzle(size, seed, colours, tiles, NULL);
+    memset(used, 0, sizeof(used));
+
+    // Every tile of the solution has to be a rotation of a different tile of the puzzle
+    for (u32 i = 0; i < count; i++)
+    {
+        u32 j;
+        for (j = 0; j < count; j++)
+        {
+            if (used[j])
+                continue;
+
+            u8 tile[4];
+            memcpy(tile, &tiles[j * 4], 4);
+            int r;
+            for (r = 0; r < 4; r++)
+            {
+                if (memcmp(tile, &solution[i * 4], 4) == 0)
+                    break;
+                gen_rotate(tile);
+            }
+            if (r < 4)
+                break;
+        }
+        if (j == count)
+            return GEN_ERR_TILE;
+        used[j] = 1;
+    }
+
+    // Then every edge shared with a neighbour has to match
+    for (u32 y = 0; y < size; y++)
+    {
+        for (u32 x = 0; x < size; x++)
+        {
+            u32 i = y * size + x;
+            if (y && EDGE(solution, i, GEN_TOP) != EDGE(solution, i - size, GEN_BOTTOM))
+                return GEN_ERR_EDGE;
+            if (x && EDGE(solution, i, GEN_LEFT) != EDGE(solution, i - 1, GEN_RIGHT))
+                return GEN_ERR_EDGE;
+        }
+    }
+
+    return GEN_OK;
+}
+
+int gen_same_solution(u8 size, const u8 *a, const u8 *b)
+{
+    u8 turned[GEN_MAX_SIZE * GEN_MAX_SIZE * 4];
+    u8 next[GEN_MAX_SIZE * GEN_MAX_SIZE * 4];
+    u32 count = size * size;
+
+    memcpy(turned, a, count * 4);
+    for (int r = 0; r < 4; r++)
+    {
+        if (memcmp(turned, b, count * 4) == 0)
+            return 1;
+
+        // Turn the whole grid a quarter clockwise, the tile at (x, y) moves to (size - 1 - y, x)
+        for (u32 y = 0; y < size; y++)
+        {
+            for (u32 x = 0; x < size; x++)
+            {
+                u8 *tile = &next[(x * size + size - 1 - y) * 4];
+                memcpy(tile, &turned[(y * size + x) * 4], 4);
+                gen_rotate(tile);
+            }
+        }
+        memcpy(turned, next, count * 4);
+    }
+    return 0;
+}
+
+const char *gen_error(int err)
+{
+    switch (err)
+    {
+        case GEN_OK:
+            return "ok";
+        case GEN_ERR_SIZE:
+            return "bad size";
+        case GEN_ERR_TILE:
+            return "tile not in puzzle";
+        case GEN_ERR_EDGE:
+            return "edges don't match";
+        default:
+            return "unknown";
+    }
+}
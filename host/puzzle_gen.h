@@ -0,0 +1,38 @@
+#ifndef __PUZZLE_GEN_H_
+#define __PUZZLE_GEN_H_
+
+#include "xil_types.h"
+
+// Deterministic edge matching puzzle generator and solution checker for the host tools
+// Tiles are kept as 4 bytes in the order they are sent over the network, top, right, bottom then left
+
+// Largest puzzle that can be generated, bigger than the solvers take so fragmentation can be tested
+#define GEN_MAX_SIZE 16
+// The core rotates edges through a 5 bit value so colours must be below this
+#define GEN_MAX_COLOURS 32
+#define GEN_DEFAULT_COLOURS 8
+
+#define GEN_TOP 0
+#define GEN_RIGHT 1
+#define GEN_BOTTOM 2
+#define GEN_LEFT 3
+
+// Results of gen_verify
+#define GEN_OK 0
+#define GEN_ERR_SIZE 1      // Size out of range
+#define GEN_ERR_TILE 2      // A tile that is not in the puzzle or is used twice
+#define GEN_ERR_EDGE 3      // Two neighbouring edges don't match
+
+// Builds the puzzle for size and seed, the same arguments always give the same puzzle
+// tiles gets the shuffled and rotated tiles that are sent to the board
+// solved, if not NULL, gets the layout the puzzle was made from which is always a valid solution
+void gen_puzzle(u8 size, u32 seed, u32 colours, u8 *tiles, u8 *solved);
+
+// Checks a solution to the puzzle for size and seed, returns GEN_OK or one of the errors above
+int gen_verify(u8 size, u32 seed, u32 colours, const u8 *solution);
+const char *gen_error(int err);
+
+// Returns 1 if b is a, or a turned a quarter, half or three quarters round, these count as the same solution
+int gen_same_solution(u8 size, const u8 *a, const u8 *b);
+
+#endif
@@ -0,0 +1,372 @@
+// Stand in for the puzzle server
+// Answers single and batch puzzle requests with puzzles from puzzle_gen.c and checks every solution sent back
+//
+// Build from the repository root with:
+//   gcc -O2 -std=gnu99 -Ihost/include -Isoftware -Ihost -o puzzle_server host/puzzle_server.c host/puzzle_gen.c
+//
+// Usage: puzzle_server [-p port] [-r reply_port] [-c colours] [-m max_payload] [-l loss] [-d size:seed] [-x] [-v]
+// Replies go to reply_port on the host that asked, 0 replies to the port the request came from
+// Boards told to send telemetry here with ":telemetry <host>" have each STATS packet printed as a line of key=value
+// -l drops that percentage of replies at random, to check the board asks again for what it doesn't get
+// -d prints the puzzle for size:seed and its solution in wire order then exits, for making regression inputs
+// -x sends puzzles with more odd colours than edges around the outside, which the board must report as infeasible
+// without searching, any result or a summary without the infeasible flag is then counted as bad
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "protocol.h"
+#include "puzzle_gen.h"
+
+static int sock;
+static int reply_port = PROTO_PORT;
+static u32 colours = GEN_DEFAULT_COLOURS;
+static u32 max_payload = PROTO_MAX_PAYLOAD;
+static int verbose;
+static int loss;
+static int corrupt;
+
+// Counters printed on exit
+static u32 requests;
+static u32 puzzles_sent;
+static u32 packets_sent;
+static u32 packets_dropped;
+static u32 results_ok;
+static u32 results_bad;
+static u32 summaries;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    stop = 1;
+}
+
+static void send_to(struct sockaddr_in *to, u8 *buf, u32 len)
+{
+    struct sockaddr_in dst = *to;
+    if (reply_port)
+        dst.sin_port = htons(reply_port);
+    if (loss && rand() % 100 < loss)
+        packets_dropped++;
+    else if (sendto(sock, buf, len, 0, (struct sockaddr *)&dst, sizeof(dst)) < 0)
+        perror("sendto");
+    else
+        packets_sent++;
+}
+
+// Sends a puzzle that doesn't fit in one datagram as fragments
+static void send_fragments(struct sockaddr_in *to, u8 size, u32 seed, u16 id, u8 *tiles)
+{
+    u8 buf[PROTO_MAX_PAYLOAD];
+    u32 count = size * size;
+    u32 per_packet = (max_payload - FRAG_HEADER_LEN) / PROTO_TILE_LEN;
+
+    for (u32 first = 0; first < count; first += per_packet)
+    {
+        u32 n = count - first < per_packet ? count - first : per_packet;
+        buf[0] = FRAG_HEADER;
+        buf[1] = size;
+        PROTO_PUT_U32(buf + 2, seed);
+        PROTO_PUT_U16(buf + 6, first);
+        PROTO_PUT_U16(buf + 8, n);
+        PROTO_PUT_U16(buf + 10, id);
+        memcpy(buf + FRAG_HEADER_LEN, tiles + first * PROTO_TILE_LEN, n * PROTO_TILE_LEN);
+        send_to(to, buf, FRAG_HEADER_LEN + n * PROTO_TILE_LEN);
+    }
+}
+
+// Recolours a puzzle so it can't have a solution, edges 0 to 4 * size each get a colour of their own and the rest
+// share one more, giving 4 * size + 2 colours used an odd number of times when only the 4 * size outside edges are unpaired
+static void corrupt_puzzle(u8 size, u8 *tiles)
+{
+    for (u32 e = 0; e < size * size * PROTO_TILE_LEN; e++)
+        tiles[e] = e < 4 * size + 1 ? e : 4 * size + 1;
+}
+
+static void handle_request(struct sockaddr_in *from, u8 size, u32 seed)
+{
+    u8 buf[PROTO_MAX_PAYLOAD];
+    u8 tiles[GEN_MAX_SIZE * GEN_MAX_SIZE * PROTO_TILE_LEN];
+
+    gen_puzzle(size, seed, colours, tiles, NULL);
+    if (corrupt)
+        corrupt_puzzle(size, tiles);
+    puzzles_sent++;
+
+    if (RESP_HEADER_LEN + PROTO_PUZZLE_LEN(size) > max_payload)
+    {
+        send_fragments(from, size, seed, 0, tiles);
+        return;
+    }
+
+    buf[0] = RESP_HEADER;
+    buf[1] = size;
+    PROTO_PUT_U32(buf + 2, seed);
+    memcpy(buf + RESP_HEADER_LEN, tiles, PROTO_PUZZLE_LEN(size));
+    send_to(from, buf, RESP_HEADER_LEN + PROTO_PUZZLE_LEN(size));
+}
+
+static void handle_batch(struct sockaddr_in *from, u8 size, u32 seed, u32 count, u16 id)
+{
+    u8 buf[PROTO_MAX_PAYLOAD];
+    u32 puzzle_len = PROTO_PUZZLE_LEN(size);
+    u32 per_packet = (max_payload - BATCH_RESP_HEADER_LEN) / puzzle_len;
+
+    // Puzzles too big to pack are each sent on their own as fragments
+    if (per_packet == 0)
+    {
+        u8 tiles[GEN_MAX_SIZE * GEN_MAX_SIZE * PROTO_TILE_LEN];
+        for (u32 i = 0; i < count; i++)
+        {
+            gen_puzzle(size, seed + i, colours, tiles, NULL);
+            if (corrupt)
+                corrupt_puzzle(size, tiles);
+            send_fragments(from, size, seed + i, id, tiles);
+            puzzles_sent++;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < count; i += per_packet)
+    {
+        u32 n = count - i < per_packet ? count - i : per_packet;
+        buf[0] = BATCH_RESP_HEADER;
+        buf[1] = size;
+        buf[2] = n;
+        PROTO_PUT_U32(buf + 3, seed + i);
+        PROTO_PUT_U16(buf + 7, id);
+        for (u32 j = 0; j < n; j++)
+        {
+            gen_puzzle(size, seed + i + j, colours, buf + BATCH_RESP_HEADER_LEN + j * puzzle_len, NULL);
+            if (corrupt)
+                corrupt_puzzle(size, buf + BATCH_RESP_HEADER_LEN + j * puzzle_len);
+        }
+        send_to(from, buf, BATCH_RESP_HEADER_LEN + n * puzzle_len);
+        puzzles_sent += n;
+    }
+}
+
+static void handle_result(struct sockaddr_in *from, u8 *buf, u32 len)
+{
+    u8 size = buf[1];
+    u32 seed = PROTO_GET_U32(buf + 2);
+    int err;
+
+    // A corrupted puzzle has no solution so anything sent back for one is wrong
+    if (size < 2 || size > GEN_MAX_SIZE || len < RESULT_HEADER_LEN + PROTO_PUZZLE_LEN(size))
+        err = GEN_ERR_SIZE;
+    else if (corrupt)
+        err = GEN_ERR_TILE;
+    else
+        err = gen_verify(size, seed, colours, buf + RESULT_HEADER_LEN);
+
+    if (err == GEN_OK)
+        results_ok++;
+    else
+        results_bad++;
+
+    if (verbose || err != GEN_OK)
+        printf("%s: result %u for size %u seed %u at %u us: %s\n", inet_ntoa(from->sin_addr),
+            buf[6], size, seed, PROTO_GET_U32(buf + 7), gen_error(err));
+}
+
+static void handle_summary(struct sockaddr_in *from, u8 *buf, u32 len)
+{
+    summaries++;
+    if (corrupt && !(buf[8] & SUMMARY_INFEASIBLE))
+    {
+        results_bad++;
+        printf("%s: size %u seed %u was searched, it should have been found infeasible\n", inet_ntoa(from->sin_addr),
+            buf[1], PROTO_GET_U32(buf + 2));
+    }
+    if (verbose)
+        printf("%s: size %u seed %u done, %u solutions in %u us%s%s%s%s\n", inet_ntoa(from->sin_addr),
+            buf[1], PROTO_GET_U32(buf + 2), PROTO_GET_U16(buf + 6), PROTO_GET_U32(buf + 9),
+            buf[8] & SUMMARY_BATCH ? " for the batch" : "",
+            buf[8] & SUMMARY_ABORTED ? ", aborted" : "", buf[8] & SUMMARY_BUF_FULL ? ", buffer full" : "",
+            buf[8] & SUMMARY_INFEASIBLE ? ", infeasible" : "");
+}
+
+static void handle_stats(struct sockaddr_in *from, u8 *buf, u32 len)
+{
+    // One line per packet in key=value form so it can be fed straight into monitoring
+    u32 cores = buf[1];
+    if (len < STATS_HEADER_LEN + cores * STATS_CORE_LEN)
+        return;
+
+    printf("stats %s uptime_ms=%u queued=%u solving=%u puzzles=%u solutions=%u rx=%u tx=%u dropped=%u",
+        inet_ntoa(from->sin_addr), PROTO_GET_U32(buf + 4), buf[2], buf[3], PROTO_GET_U32(buf + 8),
+        PROTO_GET_U32(buf + 12), PROTO_GET_U32(buf + 16), PROTO_GET_U32(buf + 20), PROTO_GET_U32(buf + 24));
+    for (u32 i = 0; i < cores; i++)
+    {
+        u8 *core = buf + STATS_HEADER_LEN + i * STATS_CORE_LEN;
+        printf(" busy%u_ms=%u runs%u=%u", i, PROTO_GET_U32(core), i, PROTO_GET_U32(core + 4));
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+static int dump_puzzle(const char *arg)
+{
+    unsigned size, seed;
+    u8 tiles[GEN_MAX_SIZE * GEN_MAX_SIZE * PROTO_TILE_LEN];
+    u8 solved[GEN_MAX_SIZE * GEN_MAX_SIZE * PROTO_TILE_LEN];
+
+    if (sscanf(arg, "%u:%u", &size, &seed) != 2 || size < 2 || size > GEN_MAX_SIZE)
+    {
+        fprintf(stderr, "-d takes size:seed with size 2-%d\n", GEN_MAX_SIZE);
+        return 1;
+    }
+
+    gen_puzzle(size, seed, colours, tiles, solved);
+    printf("puzzle");
+    for (u32 i = 0; i < size * size * PROTO_TILE_LEN; i++)
+        printf("%s%u", i % PROTO_TILE_LEN ? "," : " ", tiles[i]);
+    printf("\nsolved");
+    for (u32 i = 0; i < size * size * PROTO_TILE_LEN; i++)
+        printf("%s%u", i % PROTO_TILE_LEN ? "," : " ", solved[i]);
+    printf("\nverify %s\n", gen_error(gen_verify(size, seed, colours, solved)));
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int port = PROTO_PORT;
+    const char *dump = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:r:c:m:l:d:xv")) != -1)
+    {
+        switch (opt)
+        {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'r':
+                reply_port = atoi(optarg);
+                break;
+            case 'c':
+                colours = atoi(optarg);
+                break;
+            case 'm':
+                max_payload = atoi(optarg);
+                break;
+            case 'l':
+                loss = atoi(optarg);
+                break;
+            case 'd':
+                dump = optarg;
+                break;
+            case 'x':
+                corrupt = 1;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-r reply_port] [-c colours] [-m max_payload] [-l loss] [-d size:seed] [-x] [-v]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (colours < 1 || colours > GEN_MAX_COLOURS || max_payload < FRAG_HEADER_LEN + PROTO_TILE_LEN || max_payload > PROTO_MAX_PAYLOAD)
+    {
+        fprintf(stderr, "colours must be 1-%d and max_payload %d-%d\n", GEN_MAX_COLOURS, FRAG_HEADER_LEN + PROTO_TILE_LEN, PROTO_MAX_PAYLOAD);
+        return 1;
+    }
+    if (loss < 0 || loss > 100)
+    {
+        fprintf(stderr, "loss is a percentage, 0-100\n");
+        return 1;
+    }
+
+    if (dump)
+        return dump_puzzle(dump);
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+
+    // Stop cleanly on ctrl-c so the counters get printed, recvfrom is interrupted rather than restarted
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("Listening on port %d, %u colours\n", port, colours);
+
+    u8 buf[2048];
+    while (!stop)
+    {
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        ssize_t len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if (len <= 0)
+            continue;
+
+        switch (buf[0])
+        {
+            case REQ_HEADER:
+                if (len < sizeof(proto_req_t) || buf[1] < 2 || buf[1] > GEN_MAX_SIZE)
+                    break;
+                requests++;
+                if (verbose)
+                    printf("%s: puzzle size %u seed %u\n", inet_ntoa(from.sin_addr), buf[1], PROTO_GET_U32(buf + 2));
+                handle_request(&from, buf[1], PROTO_GET_U32(buf + 2));
+                break;
+
+            case BATCH_REQ_HEADER:
+                if (len < sizeof(proto_batch_req_t) || buf[1] < 2 || buf[1] > GEN_MAX_SIZE)
+                    break;
+                requests++;
+                if (verbose)
+                    printf("%s: %u puzzles size %u seeds from %u, request %u\n", inet_ntoa(from.sin_addr), buf[6], buf[1],
+                        PROTO_GET_U32(buf + 2), PROTO_GET_U16(buf + 7));
+                handle_batch(&from, buf[1], PROTO_GET_U32(buf + 2), buf[6], PROTO_GET_U16(buf + 7));
+                break;
+
+            case RESULT_HEADER:
+                if (len >= RESULT_HEADER_LEN)
+                    handle_result(&from, buf, len);
+                break;
+
+            case SUMMARY_HEADER:
+                if (len >= SUMMARY_LEN)
+                    handle_summary(&from, buf, len);
+                break;
+
+            case STATS_HEADER:
+                if (len >= STATS_HEADER_LEN)
+                    handle_stats(&from, buf, len);
+                break;
+
+            default:
+                if (verbose)
+                    printf("%s: unknown packet 0x%02x, %zd bytes\n", inet_ntoa(from.sin_addr), buf[0], len);
+                break;
+        }
+    }
+
+    printf("\n%u requests, %u puzzles in %u packets (%u dropped), %u results ok, %u bad, %u puzzles finished\n",
+        requests, puzzles_sent, packets_sent, packets_dropped, results_ok, results_bad, summaries);
+    return results_bad ? 2 : 0;
+}
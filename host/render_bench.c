@@ -0,0 +1,200 @@
+// Renderer benchmark
+// Times full and incremental redraws of a puzzle at every mode in vga_modes.h using the host display backend
+//
+// Build from the repository root with:
+//   gcc -O2 -std=gnu99 -Ihost/include -Isoftware -Ihost -o render_bench host/render_bench.c host/display_host.c software/render.c
+//
+// Usage: render_bench [-s size] [-c colours] [-n iterations] [-o output_dir] [-k]
+// After timing, each mode draws one fixed frame of the puzzle and panel and prints its checksum
+// With -o a PPM of that frame for each mode is written, these can be diffed against golden images
+// With -k the checksums are compared against the known good ones below and it exits with 2 if any differ,
+// this needs the default size and colours. After a change that is meant to alter the output, check the
+// PPMs by eye and copy the new checksums in
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "display_host.h"
+#include "render.h"
+
+// Every mode the firmware can be built for
+static const VideoMode *modes[] = {
+    &VMODE_640x480,
+    &VMODE_800x600,
+    &VMODE_1280x720,
+    &VMODE_1280x800,
+    &VMODE_1280x1024,
+    &VMODE_1440x900,
+    &VMODE_1680x1050
+};
+#define MODE_COUNT (sizeof(modes) / sizeof(modes[0]))
+
+// Checksums of the fixed frame for each mode in modes[] with the default size and colours
+static const u32 reference[] = {
+    0xc3b60b17,    // 640x480
+    0x12d297e9,    // 800x600
+    0xce486b05,    // 1280x720
+    0x8c995267,    // 1280x800
+    0x0992d9a7,    // 1280x1024
+    0xcf7d3c31,    // 1440x900
+    0x7e1070fd     // 1680x1050
+};
+#define DEFAULT_COLOURS 10
+
+static double now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Builds the same puzzle on every run so the output images are reproducible
+static void make_bench_puzzle(puzzle_t *puzzle, u8 size, int colours)
+{
+    u32 state = 0x12345678;
+    puzzle->size = size;
+    for (int i = 0; i < size * size; i++)
+    {
+        u8 *edges = (u8 *)&puzzle->tiles[i];
+        for (int e = 0; e < 4; e++)
+        {
+            state = state * 1103515245 + 12345;
+            edges[e] = (state >> 16) % colours;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int size = MAX_SIZE;
+    int colours = DEFAULT_COLOURS;
+    int iterations = 20;
+    const char *out_dir = NULL;
+    int check = 0;
+    int mismatches = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:c:n:o:k")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                size = atoi(optarg);
+                break;
+            case 'c':
+                colours = atoi(optarg);
+                break;
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'o':
+                out_dir = optarg;
+                break;
+            case 'k':
+                check = 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s size] [-c colours] [-n iterations] [-o output_dir] [-k]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (size < 2 || size > MAX_SIZE || colours < 1 || colours > PALETTE_SIZE || iterations < 1)
+    {
+        fprintf(stderr, "size must be 2-%d, colours 1-%d and iterations positive\n", MAX_SIZE, PALETTE_SIZE);
+        return 1;
+    }
+    if (check && (size != MAX_SIZE || colours != DEFAULT_COLOURS))
+    {
+        fprintf(stderr, "-k only has checksums for size %d and %d colours\n", MAX_SIZE, DEFAULT_COLOURS);
+        return 1;
+    }
+
+    puzzle_t puzzle;
+    palette_init();
+    make_bench_puzzle(&puzzle, size, colours);
+
+    panel_info_t info = {
+        .size = size,
+        .seed = 0,
+        .sol_idx = 0,
+        .sol_count = 1,
+        .solvers_running = 4,
+        .solver_count = 4
+    };
+
+    printf("%-16s %6s %12s %12s %12s %10s\n", "mode", "tile", "full (us)", "tile (us)", "panel (us)", "checksum");
+    for (int m = 0; m < MODE_COUNT; m++)
+    {
+        display_t disp;
+        if (display_init(&disp, modes[m]) != XST_SUCCESS)
+        {
+            fprintf(stderr, "could not allocate %s\n", modes[m]->label);
+            return 1;
+        }
+
+        layout_t layout;
+        layout_compute(&layout, disp.surface.width, disp.surface.height, size);
+
+        // Full redraw, this is what happens when a new puzzle or solution is shown
+        double start = now_us();
+        for (int i = 0; i < iterations; i++)
+        {
+            render_puzzle(&disp.surface, &layout, puzzle.tiles);
+            render_panel(&disp.surface, &layout, &info);
+            display_flush(&disp);
+        }
+        double full = (now_us() - start) / iterations;
+
+        // Incremental redraw of a single tile in each position
+        start = now_us();
+        for (int i = 0; i < iterations; i++)
+        {
+            for (int t = 0; t < size * size; t++)
+                render_tile(&disp.surface, &layout, &puzzle.tiles[t], t);
+            display_flush(&disp);
+        }
+        double tile = (now_us() - start) / (iterations * size * size);
+
+        // Side panel only, this is redrawn whenever the solver stats change
+        start = now_us();
+        for (int i = 0; i < iterations; i++)
+        {
+            info.sol_count = i + 1;
+            render_panel(&disp.surface, &layout, &info);
+            display_flush(&disp);
+        }
+        double panel = (now_us() - start) / iterations;
+
+        // The frame that is checked, drawn the same way whatever the timing runs left behind
+        info.sol_count = 1;
+        render_puzzle(&disp.surface, &layout, puzzle.tiles);
+        render_panel(&disp.surface, &layout, &info);
+        display_flush(&disp);
+        u32 checksum = display_checksum(&disp);
+
+        printf("%-16s %6u %12.1f %12.2f %12.1f   %08x", modes[m]->label, layout.tile_size, full, tile, panel, checksum);
+        if (check && checksum != reference[m])
+        {
+            printf(" expected %08x", reference[m]);
+            mismatches++;
+        }
+        printf("\n");
+
+        if (out_dir)
+        {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%ux%u.ppm", out_dir, modes[m]->width, modes[m]->height);
+            if (display_write_ppm(&disp, path) != XST_SUCCESS)
+                fprintf(stderr, "could not write %s\n", path);
+        }
+
+        display_free(&disp);
+    }
+
+    if (check)
+        printf("%d of %d frames differ from the reference\n", mismatches, (int)MODE_COUNT);
+    return mismatches ? 2 : 0;
+}
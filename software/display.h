@@ -0,0 +1,39 @@
+#ifndef __DISPLAY_H_
+#define __DISPLAY_H_
+
+#include "xil_types.h"
+#include "zybo_z7_hdmi/vga_modes.h"
+
+// Bit positions of the colour channels in a pixel
+// These match BIT_DISPLAY_* in display_ctrl.h so the renderer does not need the Xilinx drivers
+#define PIXEL_BIT_RED 16
+#define PIXEL_BIT_GREEN 8
+#define PIXEL_BIT_BLUE 0
+
+// Packs an 8 bit per channel colour into a pixel
+#define MAKE_PIXEL(r, g, b) (((u32)(r) << PIXEL_BIT_RED) | ((u32)(g) << PIXEL_BIT_GREEN) | ((u32)(b) << PIXEL_BIT_BLUE))
+
+// A frame the renderer draws into
+// stride is in pixels rather than bytes so it can be used directly as an index
+typedef struct {
+    u32 *frame;
+    u32 stride;
+    u32 width;
+    u32 height;
+} surface_t;
+
+// A display backend
+// surface always points at the frame that is currently being shown
+// priv is owned by the backend
+typedef struct {
+    VideoMode mode;
+    surface_t surface;
+    void *priv;
+} display_t;
+
+// These are implemented once per backend
+// display_hdmi.c drives the Zybo HDMI output, host/display_host.c renders into plain memory
+int display_init(display_t *disp, const VideoMode *mode);
+void display_flush(display_t *disp);
+
+#endif
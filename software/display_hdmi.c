@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include "xparameters.h"
+#include "xil_cache.h"
+#include "zybo_z7_hdmi/display_ctrl.h"
+#include "display.h"
+
+// Frame size (based on the largest mode in vga_modes.h, 1680x1050, 32 bits per pixel)
+// Only width * height of each buffer is used and scanned out for smaller modes
+#define MAX_FRAME (1680*1050)
+
+DisplayCtrl dispCtrl; // Display driver struct
+u32 frameBuf[DISPLAY_NUM_FRAMES][MAX_FRAME]; // Frame buffers for video data
+void *pFrames[DISPLAY_NUM_FRAMES]; // Array of pointers to the frame buffers
+
+int display_init(display_t *disp, const VideoMode *mode)
+{
+    // Initialise an array of pointers to the 2 frame buffers
+	int i;
+	for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
+		pFrames[i] = frameBuf[i];
+
+	if (mode->width * mode->height > MAX_FRAME)
+		return XST_FAILURE;
+
+    // Initialise the display controller
+    // The frames are packed so the stride is taken from the width of the mode being set
+	if (DisplayInitialize(&dispCtrl, XPAR_AXIVDMA_0_DEVICE_ID, XPAR_VTC_0_DEVICE_ID, XPAR_HDMI_AXI_DYNCLK_0_BASEADDR, pFrames, mode->width * 4) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	// Use first frame buffer (of two)
+	DisplayChangeFrame(&dispCtrl, 0);
+
+	// Set the display resolution
+	DisplaySetMode(&dispCtrl, mode);
+
+	// Enable video output
+	if (DisplayStart(&dispCtrl) != XST_SUCCESS)
+		return XST_FAILURE;
+
+	printf("\n\r");
+	printf("HDMI output enabled\n\r");
+	printf("Current Resolution: %s\n\r", dispCtrl.vMode.label);
+	printf("Pixel Clock Frequency: %.3fMHz\n\r", dispCtrl.pxlFreq);
+
+	// Get parameters from display controller struct
+	disp->mode = dispCtrl.vMode;
+	disp->surface.frame = (u32 *)dispCtrl.framePtr[dispCtrl.curFrame];
+	disp->surface.stride = dispCtrl.stride / 4;
+	disp->surface.width = dispCtrl.vMode.width;
+	disp->surface.height = dispCtrl.vMode.height;
+	disp->priv = &dispCtrl;
+
+	return XST_SUCCESS;
+}
+
+void display_flush(display_t *disp)
+{
+	// Flush the cache, so the Video DMA core can pick up our frame buffer changes.
+	// Flushing the entire cache (rather than a subset of cache lines) makes sense as our buffer is so big
+	Xil_DCacheFlush();
+}
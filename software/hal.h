@@ -0,0 +1,52 @@
+#ifndef __HAL_H_
+#define __HAL_H_
+
+#include "xil_types.h"
+#include "puzzle.h"
+
+// The board specific parts of the firmware that main.c uses, so the rest of it can also be run as a Linux process
+// hal_zynq.c drives the Zybo, host/hal_linux.c runs each solver core as a thread on the core's C source
+// The network and the timer are behind platform.h and net.h, and the display behind display.h, which the Linux
+// build also provides
+
+// Most solver cores there can be
+#define HAL_MAX_CORES 16
+
+// The data cache line size, memory a core writes to must start on a line and fill whole lines
+// Otherwise flushing the processor's copy of a shared line writes stale data over what the core wrote
+#define HAL_CACHE_LINE 32
+
+// What hal_core_result() gives, the core's TOPLEVEL_ return values
+#define HAL_CORE_DONE 0
+#define HAL_CORE_SOLUTION 1
+#define HAL_CORE_BUDGET 2
+
+// Solver cores, these take the same arguments as the core's registers
+// Cores are numbered from 0 to hal_core_count() - 1, hal_core_init() fails for one that is missing or not responding
+// ram is where the core reads the puzzle from and writes a solution to, it must hold MAX_SIZE * MAX_SIZE tiles
+// filter is the Bloom filter of solutions already found, SOLUTION_FILTER_WORDS long, the core only reads it
+// hal_core_init() also takes the core out of batch mode, hal_core_set_batch() puts it in it until the next init
+// A batch core reads count puzzles from descs, filter is then its own to write to
+u32 hal_core_count();
+int hal_core_init(u32 core, tile_t *ram, u32 *filter);
+void hal_core_set_batch(u32 core, batch_desc_t *descs, u32 *filter, u8 count);
+void hal_core_set_reset(u32 core, u8 reset);
+void hal_core_setup(u32 core, u8 size, u8 start_idx, u8 end_idx);
+void hal_core_set_abort(u32 core, u8 abort);
+// Stop after budget nodes, 0 for no limit, and try the tiles in an order shuffled from seed, 0 for the order in ram
+// The seed is only read when the core is started with reset set
+void hal_core_set_search(u32 core, u32 budget, u16 seed);
+void hal_core_start(u32 core);
+u8 hal_core_done(u32 core);
+u8 hal_core_result(u32 core);
+
+// Keeping memory shared with the cores coherent, flush before a core reads it and invalidate before reading what it wrote
+void hal_cache_flush(void *addr, u32 len);
+void hal_cache_invalidate(void *addr, u32 len);
+
+// The console
+u8 hal_console_ready();
+char hal_console_read();
+void hal_console_write(char c);
+
+#endif
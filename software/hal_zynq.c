@@ -0,0 +1,98 @@
+#include "xparameters.h"
+#include "xil_cache.h"
+#include "xil_printf.h"
+#include "xtoplevel.h"
+#include "xuartps_hw.h"
+#include "hal.h"
+
+// The HLS solver cores, core n is the one with device id n
+static XToplevel cores[HAL_MAX_CORES];
+
+u32 hal_core_count()
+{
+    // Every instance of the core in the block design is listed in xparameters.h
+    return XPAR_XTOPLEVEL_NUM_INSTANCES < HAL_MAX_CORES ? XPAR_XTOPLEVEL_NUM_INSTANCES : HAL_MAX_CORES;
+}
+
+int hal_core_init(u32 core, tile_t *ram, u32 *filter)
+{
+    if (core >= hal_core_count() || XToplevel_Initialize(&cores[core], core) != XST_SUCCESS)
+        return XST_FAILURE;
+    // A core is only ever set up between searches, one that is not idle then is stuck or held in reset
+    if (!XToplevel_IsIdle(&cores[core]))
+        return XST_FAILURE;
+    XToplevel_Set_ram(&cores[core], (int)ram);
+    XToplevel_Set_filter(&cores[core], (int)filter);
+    XToplevel_Set_in_batch(&cores[core], 0);
+    return XST_SUCCESS;
+}
+
+void hal_core_set_reset(u32 core, u8 reset)
+{
+    XToplevel_Set_reset(&cores[core], reset);
+}
+
+void hal_core_setup(u32 core, u8 size, u8 start_idx, u8 end_idx)
+{
+    XToplevel_Set_in_size(&cores[core], size);
+    XToplevel_Set_in_start_idx(&cores[core], start_idx);
+    XToplevel_Set_in_end_idx(&cores[core], end_idx);
+}
+
+void hal_core_set_batch(u32 core, batch_desc_t *descs, u32 *filter, u8 count)
+{
+    XToplevel_Set_ram(&cores[core], (int)descs);
+    XToplevel_Set_filter(&cores[core], (int)filter);
+    XToplevel_Set_in_batch(&cores[core], count);
+}
+
+void hal_core_set_abort(u32 core, u8 abort)
+{
+    XToplevel_Set_abort(&cores[core], abort);
+}
+
+void hal_core_set_search(u32 core, u32 budget, u16 seed)
+{
+    XToplevel_Set_in_budget(&cores[core], budget);
+    XToplevel_Set_in_seed(&cores[core], seed);
+}
+
+void hal_core_start(u32 core)
+{
+    XToplevel_Start(&cores[core]);
+}
+
+u8 hal_core_done(u32 core)
+{
+    return XToplevel_IsDone(&cores[core]);
+}
+
+u8 hal_core_result(u32 core)
+{
+    return XToplevel_Get_return(&cores[core]);
+}
+
+void hal_cache_flush(void *addr, u32 len)
+{
+    Xil_DCacheFlushRange((UINTPTR)addr, len);
+}
+
+void hal_cache_invalidate(void *addr, u32 len)
+{
+    Xil_DCacheInvalidateRange((UINTPTR)addr, len);
+}
+
+u8 hal_console_ready()
+{
+    return XUartPs_IsReceiveData(STDIN_BASEADDRESS);
+}
+
+char hal_console_read()
+{
+    return XUartPs_RecvByte(STDIN_BASEADDRESS);
+}
+
+void hal_console_write(char c)
+{
+    outbyte(c);
+}
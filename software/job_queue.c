@@ -0,0 +1,71 @@
+#include "job_queue.h"
+
+void job_queue_clear(job_queue_t *q)
+{
+    q->head = 0;
+    q->count = 0;
+}
+
+u32 job_queue_count(job_queue_t *q)
+{
+    return q->count;
+}
+
+u32 job_queue_free(job_queue_t *q)
+{
+    return JOB_QUEUE_SIZE - q->count;
+}
+
+job_t *job_queue_reserve(job_queue_t *q)
+{
+    // Returns the slot the next job should be written to, or NULL if the queue is full
+    // The job is not in the queue until job_queue_push() is called
+    if (q->count == JOB_QUEUE_SIZE)
+        return NULL;
+    return &q->jobs[(q->head + q->count) % JOB_QUEUE_SIZE];
+}
+
+void job_queue_push(job_queue_t *q)
+{
+    if (q->count < JOB_QUEUE_SIZE)
+        q->count++;
+}
+
+job_t *job_queue_peek(job_queue_t *q)
+{
+    // The job at the front stays valid until it is popped
+    if (q->count == 0)
+        return NULL;
+    return &q->jobs[q->head];
+}
+
+job_t *job_queue_peek_last(job_queue_t *q)
+{
+    // The most recently pushed job
+    if (q->count == 0)
+        return NULL;
+    return &q->jobs[(q->head + q->count - 1) % JOB_QUEUE_SIZE];
+}
+
+job_t *job_queue_at(job_queue_t *q, u32 i)
+{
+    // The i'th job from the front, 0 is the same as job_queue_peek()
+    if (i >= q->count)
+        return NULL;
+    return &q->jobs[(q->head + i) % JOB_QUEUE_SIZE];
+}
+
+void job_queue_pop(job_queue_t *q)
+{
+    if (q->count == 0)
+        return;
+    q->head = (q->head + 1) % JOB_QUEUE_SIZE;
+    q->count--;
+}
+
+void job_queue_drop_last(job_queue_t *q)
+{
+    // Removes the most recently pushed job
+    if (q->count > 0)
+        q->count--;
+}
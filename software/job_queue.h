@@ -0,0 +1,42 @@
+#ifndef __JOB_QUEUE_H_
+#define __JOB_QUEUE_H_
+
+#include "lwip/ip_addr.h"
+#include "puzzle.h"
+
+// Number of puzzles that can be waiting to be solved, including the one being solved
+#define JOB_QUEUE_SIZE 16
+
+// A puzzle recieved from the server, the seed it was generated from and where to send the results
+// Jobs from a cluster coordinator are a part of a puzzle, seed then holds the job id
+// The solvers only try tiles start_idx to end_idx - 1 in the first position, this is every tile for a whole puzzle
+typedef struct {
+    u32 seed;
+    ip_addr_t from;
+    u16 from_port;
+    u8 cluster;
+    u8 start_idx;
+    u8 end_idx;
+    puzzle_t puzzle;
+} job_t;
+
+// Ring buffer of jobs
+// Jobs are written in place with job_queue_reserve() and job_queue_push() so they are never copied
+typedef struct {
+    job_t jobs[JOB_QUEUE_SIZE];
+    u32 head;
+    u32 count;
+} job_queue_t;
+
+void job_queue_clear(job_queue_t *q);
+u32 job_queue_count(job_queue_t *q);
+u32 job_queue_free(job_queue_t *q);
+job_t *job_queue_reserve(job_queue_t *q);
+void job_queue_push(job_queue_t *q);
+job_t *job_queue_peek(job_queue_t *q);
+job_t *job_queue_peek_last(job_queue_t *q);
+job_t *job_queue_at(job_queue_t *q, u32 i);
+void job_queue_pop(job_queue_t *q);
+void job_queue_drop_last(job_queue_t *q);
+
+#endif
@@ -1,114 +1,172 @@
 #include <stdio.h>
-#include "xparameters.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
 #include "platform.h"
 #include "xil_printf.h"
-#include "xil_cache.h"
-#include "zybo_z7_hdmi/display_ctrl.h"
-#include "xtoplevel.h"
-#include "xuartps_hw.h"
-
-// Frame size (based on 1440x900 resolution, 32 bits per pixel)
-#define MAX_FRAME (1440*900)
-#define FRAME_STRIDE (1440*4)
-// The header of the response from the server
-#define RESP_HEADER 0x02
-// Maximum size of a puzzle
-#define MAX_SIZE 10
+#include "hal.h"
+#include "display.h"
+#include "render.h"
+#include "puzzle.h"
+#include "job_queue.h"
+#include "protocol.h"
+#include "net_config.h"
+#include "net.h"
+#include "stats.h"
+#include "request_table.h"
+#include "sw_solver.h"
+
 // Maximum size of the buffer for storing solutions
 #define MAX_BUF_SIZE 20
-// Number of hardware solvers
-#define SOLVER_COUNT 4
-
-#define RED_CODE 0x00
-#define GREEN_CODE 0x01
-#define BLUE_CODE 0x02
-#define YELLOW_CODE 0x03
-#define MAGENTA_CODE 0x04
-#define CYAN_CODE 0x05
-#define WHITE_CODE 0x06
-#define PURPLE_CODE 0x07
-#define ORANGE_CODE 0x08
-#define LIME_CODE 0x09
-// Generates the pixel values for the colours
-#define RED     (0xFF << BIT_DISPLAY_RED) | (0x00 << BIT_DISPLAY_GREEN) | (0x00 << BIT_DISPLAY_BLUE)
-#define GREEN   (0x00 << BIT_DISPLAY_RED) | (0xFF << BIT_DISPLAY_GREEN) | (0x00 << BIT_DISPLAY_BLUE)
-#define BLUE    (0x00 << BIT_DISPLAY_RED) | (0x00 << BIT_DISPLAY_GREEN) | (0xFF << BIT_DISPLAY_BLUE)
-#define YELLOW  (0xFF << BIT_DISPLAY_RED) | (0xFF << BIT_DISPLAY_GREEN) | (0x00 << BIT_DISPLAY_BLUE)
-#define MAGENTA (0xFF << BIT_DISPLAY_RED) | (0x00 << BIT_DISPLAY_GREEN) | (0xFF << BIT_DISPLAY_BLUE)
-#define CYAN    (0x00 << BIT_DISPLAY_RED) | (0xFF << BIT_DISPLAY_GREEN) | (0xFF << BIT_DISPLAY_BLUE)
-#define WHITE   (0xFF << BIT_DISPLAY_RED) | (0xFF << BIT_DISPLAY_GREEN) | (0xFF << BIT_DISPLAY_BLUE)
-#define PURPLE  (0x63 << BIT_DISPLAY_RED) | (0x00 << BIT_DISPLAY_GREEN) | (0x99 << BIT_DISPLAY_BLUE)
-#define ORANGE  (0xFF << BIT_DISPLAY_RED) | (0x94 << BIT_DISPLAY_GREEN) | (0x00 << BIT_DISPLAY_BLUE)
-#define LIME    (0x53 << BIT_DISPLAY_RED) | (0x56 << BIT_DISPLAY_GREEN) | (0x1B << BIT_DISPLAY_BLUE)
-
-// Makes a tile with the given colours
-#define MAKE_TILE(c1, c2, c3, c4) ((c1 << 24) | (c2 <<16) | (c3 << 8) | (c4))
+// Set to 1 to start in first solution mode, it can be toggled with 'f'
+#ifndef FIRST_SOLUTION
+#define FIRST_SOLUTION 0
+#endif
+// In first solution mode the hardware solvers other than the first give up on an order after this many nodes
+// times the next number of the Luby sequence and restart with a new one, so none stays stuck under a bad early choice
+#ifndef RESTART_NODES
+#define RESTART_NODES 20000
+#endif
+// Puzzles no bigger than this are solved in batches when several are waiting, each one on a single solver core
+// For these setting up and starting the cores for every first tile takes longer than the search itself
+#ifndef BATCH_MAX_SIZE
+#define BATCH_MAX_SIZE 5
+#endif
+// Most puzzles given to one core in a batch
+#define BATCH_PER_CORE 4
+// Set to 0 to leave the search to the hardware solvers alone
+#ifndef SW_SOLVER
+#define SW_SOLVER 1
+#endif
+// Steps the software solver takes between polls, this keeps the hardware solvers and the network waiting no more than
+// a few hundred microseconds
+#define SW_SOLVER_STEPS 500
+// How many puzzles are asked for ahead of the one being solved
+#define PREFETCH_DEPTH 8
+// Most puzzles that can be asked for at once from the console, a bigger count is cut down to this
+#define MAX_RUN_COUNT 10000
+// Set to 0 for servers that only understand single puzzle requests
+#ifndef USE_BATCH_REQUESTS
+#define USE_BATCH_REQUESTS 1
+#endif
+// The video mode to output, any mode from vga_modes.h can be used
+#ifndef DISPLAY_MODE
+#define DISPLAY_MODE VMODE_1440x900
+#endif
+
+// Set to 0 to leave the screen blank until the first puzzle arrives
+#ifndef BOOT_SPLASH
+#define BOOT_SPLASH 1
+#endif
+// Maximum number of boot stages that are timed
+#define MAX_BOOT_STAGES 8
 
 // The statemachine for the software
 // This is so the main loop knows what to do
 #define GET_SIZE 0
 #define GET_SEED 1
-#define RUN_PUZZLE 2
-#define RUNNING 3
-
-// Struct to send the data to the server to request the puzzle
-// seed is 4 bytes but is represented as a byte array so that the alignment of the struct is 1 byte
-typedef struct {
-    u8 req_header;
-    u8 size;
-    u8 seed[4];
-} req_t;
-
-// Struct for the tiles
-typedef struct {
-    u8 top;
-    u8 bottom;
-    u8 left;
-    u8 right;
-} tile_t;
+#define GET_COUNT 2
+#define RUN_PUZZLE 3
+#define RUNNING 4
 
-// Struct to store a recieved puzzle
+// A point during boot and the time it was reached
 typedef struct {
-    u8 size;
-    tile_t tiles[MAX_SIZE * MAX_SIZE];
-} puzzle_t;
+    const char *name;
+    u32 time_us;
+} boot_stage_t;
 
-tile_t make_tile(u32 data);
-puzzle_t make_puzzle(u8 size, u32 *data);
+void boot_stage(const char *name);
+void boot_report();
+u8 decode_tiles(struct pbuf *p, u16 offset, tile_t *dst, u32 count);
 void udp_get_handler(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
+void handle_puzzles(u8 size, u32 seed, u32 count, u16 id, struct pbuf *p, u16 offset, const ip_addr_t *addr, u16 port);
+void handle_fragment(u8 size, u32 seed, u32 first, u32 count, u16 id, struct pbuf *p, u16 offset, const ip_addr_t *addr, u16 port);
+void handle_job(u8 *hdr, struct pbuf *p, const ip_addr_t *addr, u16 port);
+void send_advertise(const ip_addr_t *ip, u16 port);
+void send_job_done(const ip_addr_t *ip, u16 port, u32 id, u32 solutions, u8 flags, u32 time);
+void handle_config(struct pbuf *p, const ip_addr_t *addr, u16 port);
+void print_prompt();
+void send_request(void *payload, u16 len);
+void send_result(tile_t *tiles, u32 index);
+void send_summary(u32 solutions, u8 flags, u32 time_us);
 void request_puzzle(u8 size, u32 seed);
-void display_tile(tile_t* tile, u8 size, u32 idx);
-u32 get_color(u8 color);
+void request_batch(u8 size, u32 seed, u8 count, u16 id);
+void resend_request(request_t *r);
+void pump_requests();
+void poll_events();
+void cancel_batch();
+u8 start_next_job(u8 draw);
 void display_puzzle(tile_t* puzzle, uint32_t size);
+void display_panel();
 void init_hdmi();
 void print_puzzle(tile_t *tiles, uint32_t size);
 uint8_t traverse_puzzles(char byte);
 u8 puzzle_eq(tile_t *p1, tile_t *p2, u8 size);
+u8 puzzle_eq_turned(tile_t *p1, tile_t *p2, u8 size);
 u8 is_sol_unique(tile_t *p);
+u8 puzzle_feasible(puzzle_t *p);
 u8 all_done(u8 *arr);
+void shuffle_tiles(tile_t *t, u32 count, u32 seed);
+void start_solver(int i, u8 first, u8 end, u32 shuffle);
+u32 luby(u32 i);
+void restart_solver(int i);
+u8 add_solution(tile_t *grid, u8 to_filter);
+u32 batch_jobs();
+u8 solve_batch(u32 count);
 void solve_puzzle();
 
-// Global object for the current puzzle being solved or has just been solved
-puzzle_t current_puzzle;
-// Array of tiles to be used as memory for the hardware solvers
-tile_t tiles[SOLVER_COUNT][MAX_SIZE * MAX_SIZE];
+// Puzzles recieved from the server that are waiting to be solved
+// The job at the front is the one being solved or that has just been solved
+job_queue_t job_queue;
+// The puzzle being solved or that has just been solved, this points into job_queue
+puzzle_t *current_puzzle;
+// The job the current puzzle came with, this is also at the front of job_queue
+job_t *current_job;
+// The seed the current puzzle was generated from
+u32 current_seed;
+// The memory a solver core reads its puzzle from and writes its solutions to
+// Each is padded out to whole cache lines so that flushing one solver's memory never touches another's
+typedef struct {
+	tile_t tiles[MAX_SIZE * MAX_SIZE];
+} __attribute__((aligned(HAL_CACHE_LINE))) solver_ram_t;
+
+// The solver cores found at boot, solver i is core solver_cores[i] and uses solver_ram[i] as its memory
+// Cores that don't respond are left out so the rest carry on without them
+u8 solver_cores[HAL_MAX_CORES];
+u32 solver_count;
+solver_ram_t solver_ram[HAL_MAX_CORES];
+// Searches on the processor while it waits for the hardware solvers, it is counted as core solver_count in the stats
+sw_solver_t sw_solver;
+// The puzzles of a batch given to each solver, and the filter each solver keeps of what it has found while on a batch
+typedef struct {
+	u32 words[SOLUTION_FILTER_WORDS];
+} __attribute__((aligned(HAL_CACHE_LINE))) batch_filter_t;
+batch_desc_t batch_descs[HAL_MAX_CORES][BATCH_PER_CORE];
+batch_filter_t batch_filters[HAL_MAX_CORES];
 
 // The buffer for solutions to display
 uint32_t sol_buf[MAX_BUF_SIZE][MAX_SIZE * MAX_SIZE];
 // How many solutions are currently in the buffer
 int32_t sol_buf_size;
+// The solution_hash() of each solution in the buffer, only solutions with the same hash are compared tile by tile
+u32 sol_hash[MAX_BUF_SIZE];
+// The Bloom filter of the solutions in the buffer, the solver cores skip a solution that is in it rather than write it back
+u32 sol_filter[SOLUTION_FILTER_WORDS];
 // Current solution being displayed, note if -1 then the original puzzle layout from the server is displayed
 int32_t sol_buf_idx;
 
-// Array of hardware solvers
-XToplevel hls[SOLVER_COUNT];
+// How many of the hardware solvers are currently searching, shown in the side panel
+u32 solvers_running;
 
-DisplayCtrl dispCtrl; // Display driver struct
-u32 frameBuf[DISPLAY_NUM_FRAMES][MAX_FRAME]; // Frame buffers for video data
-void *pFrames[DISPLAY_NUM_FRAMES]; // Array of pointers to the frame buffers
+// The display backend the puzzles are drawn to
+display_t display;
+// Where the tiles and side panel go for the current puzzle size
+layout_t layout;
 
 // State so that the software knows if it needs to get the size or seed or if it is solving a puzzle
 u8 state;
+// The state whose prompt is the last one on the console, set by print_prompt()
+u8 prompt_state;
 
 // Char buffer to store data from the serial
 char char_buffer[255];
@@ -118,257 +176,589 @@ u32 char_buffer_idx = 0;
 u32 input_size;
 u32 seed;
 
-// Global object for requesting puzzles from the server
-req_t req;
+// Global objects for requesting puzzles from the server
+proto_req_t req;
+proto_batch_req_t batch_req;
+
+// Packets sent back to the host a puzzle came from
+u8 result_buf[RESULT_HEADER_LEN + MAX_SIZE * MAX_SIZE * PROTO_TILE_LEN];
+proto_summary_t summary;
+proto_advertise_t advertise;
+proto_job_done_t job_done;
+u8 config_ack[CONFIG_ACK_LEN];
+// When the current puzzle was started, results are timed from this
+u32 solve_start_us;
+
+// Set to also print every puzzle and solution over the UART, toggled with 'v'
+// This is off by default as at 115200 baud printing a solution can take longer than finding it
+u8 verbose;
+// Set to stop at the first solution, toggled with 'f'
+// Every solver then searches the whole puzzle with the tiles in its own order and the first to find a solution stops the rest
+u8 first_solution = FIRST_SOLUTION;
+// How many times each hardware solver has restarted on the current puzzle
+u32 restarts[HAL_MAX_CORES];
+
+// The batch of puzzles asked for on the console, seeds are requested in order from batch_next_seed
+u32 batch_next_seed;
+// Seeds in the batch that have not been requested yet
+u32 batch_to_request;
+// Puzzles that have been requested but not recieved
+u32 batch_outstanding;
+// The requests those puzzles were asked for in, replies that don't match one are dropped
+request_table_t requests;
+
+// The puzzle being put back together from fragments, it is written straight into a reserved job slot
+job_t *frag_job;
+// Which tiles of it have arrived so repeated fragments are not counted twice
+u8 frag_have[MAX_SIZE * MAX_SIZE];
+u32 frag_count;
+// The id of the request its fragments answer
+u16 frag_id;
+
+// Times of each boot stage, reported once the first puzzle has been accepted
+boot_stage_t boot_stages[MAX_BOOT_STAGES];
+u32 boot_stage_count;
+u8 boot_reported;
+
+void boot_stage(const char *name)
+{
+	// Record when a stage of boot was reached, this is cheap so it does not slow boot down
+	if (boot_stage_count < MAX_BOOT_STAGES)
+	{
+		boot_stages[boot_stage_count].name = name;
+		boot_stages[boot_stage_count].time_us = platform_time_us();
+		boot_stage_count++;
+	}
+}
+
+void boot_report()
+{
+	// Print all of the boot stages with the time since the timer was started and since the previous stage
+	u32 prev = 0;
+	xil_printf("Boot timings:\r\n");
+	for (int i = 0; i < boot_stage_count; i++)
+	{
+		xil_printf("  %s: %u us (+%u us)\r\n", boot_stages[i].name, boot_stages[i].time_us, boot_stages[i].time_us - prev);
+		prev = boot_stages[i].time_us;
+	}
+	boot_reported = 1;
+}
+
+u8 decode_tiles(struct pbuf *p, u16 offset, tile_t *dst, u32 count)
+{
+	// Tiles are sent top, right, bottom, left, this is where each of those bytes goes in a tile_t
+	static const u8 edge_offset[PROTO_TILE_LEN] = {
+		offsetof(tile_t, top),
+		offsetof(tile_t, right),
+		offsetof(tile_t, bottom),
+		offsetof(tile_t, left)
+	};
+
+	u32 len = count * PROTO_TILE_LEN;
+	if (offset + len > p->tot_len)
+		return 0;
+
+	// Walk the pbuf chain reading a byte at a time, a tile can be split across two pbufs
+	// This writes the tiles straight to where they are needed with no alignment requirements on the payload
+	u32 byte = 0;
+	for (; p && byte < len; p = p->next)
+	{
+		if (offset >= p->len)
+		{
+			offset -= p->len;
+			continue;
+		}
+
+		u8 *data = (u8 *)p->payload + offset;
+		u32 avail = p->len - offset;
+		offset = 0;
+		for (u32 i = 0; i < avail && byte < len; i++, byte++)
+			((u8 *)&dst[byte / PROTO_TILE_LEN])[edge_offset[byte % PROTO_TILE_LEN]] = data[i];
+	}
+
+	return 1;
+}
+
+void handle_puzzles(u8 size, u32 seed, u32 count, u16 id, struct pbuf *p, u16 offset, const ip_addr_t *addr, u16 port)
+{
+	// Queue count whole puzzles for consecutive seeds, they are started by the main loop as soon as the solvers are free
+	// The server sends all the fragments of a puzzle before the next one, so a puzzle that was being put together is lost
+	if (frag_job && count > 0)
+	{
+		xil_printf("Incomplete puzzle, dropped seed %u\r\n", frag_job->seed);
+		frag_job = NULL;
+	}
+
+	for (u32 i = 0; i < count; i++)
+	{
+		// Ignore anything we didn't ask for or already have, such as late replies to a cancelled batch
+		// or a second copy of a puzzle after a retry
+		request_t *r = request_match(&requests, size, seed + i, id);
+		if (!r)
+			continue;
+
+		job_t *job = job_queue_reserve(&job_queue);
+		if (!job)
+		{
+			xil_printf("Job queue full, dropped seed %u\r\n", seed + i);
+			return;
+		}
+		// The tiles are decoded straight into the queue, a short packet leaves the slot free for the next puzzle
+		if (!decode_tiles(p, offset + i * PROTO_PUZZLE_LEN(size), job->puzzle.tiles, size * size))
+		{
+			xil_printf("Short packet, dropped seed %u\r\n", seed + i);
+			return;
+		}
+		request_received(r, seed + i);
+		batch_outstanding--;
+		job->seed = seed + i;
+		ip_addr_copy(job->from, *addr);
+		job->from_port = port;
+		job->cluster = 0;
+		job->start_idx = 0;
+		job->end_idx = size * size;
+		job->puzzle.size = size;
+		job_queue_push(&job_queue);
+	}
+}
+
+void handle_fragment(u8 size, u32 seed, u32 first, u32 count, u16 id, struct pbuf *p, u16 offset, const ip_addr_t *addr, u16 port)
+{
+	u32 total = size * size;
+	if (first + count > total)
+		return;
+
+	// A fragment of a different puzzle means the one being put together is never going to be finished
+	// The slot is only pushed once complete so it is simply reused
+	if (frag_job && (frag_job->seed != seed || frag_job->puzzle.size != size || frag_id != id))
+		frag_job = NULL;
+
+	if (!frag_job)
+	{
+		if (!request_match(&requests, size, seed, id))
+			return;
+		frag_job = job_queue_reserve(&job_queue);
+		if (!frag_job)
+		{
+			xil_printf("Job queue full, dropped seed %u\r\n", seed);
+			return;
+		}
+		frag_job->seed = seed;
+		ip_addr_copy(frag_job->from, *addr);
+		frag_job->from_port = port;
+		frag_job->cluster = 0;
+		frag_job->start_idx = 0;
+		frag_job->end_idx = total;
+		frag_job->puzzle.size = size;
+		frag_id = id;
+		memset(frag_have, 0, sizeof(frag_have));
+		frag_count = 0;
+	}
+
+	if (!decode_tiles(p, offset, &frag_job->puzzle.tiles[first], count))
+		return;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		if (!frag_have[first + i])
+		{
+			frag_have[first + i] = 1;
+			frag_count++;
+		}
+	}
+
+	if (frag_count == total)
+	{
+		// The request may have been given up on while the puzzle was being put back together
+		request_t *r = request_match(&requests, size, seed, id);
+		if (r)
+		{
+			request_received(r, seed);
+			job_queue_push(&job_queue);
+			batch_outstanding--;
+		}
+		frag_job = NULL;
+	}
+}
 
-tile_t make_tile(u32 data)
+void handle_job(u8 *hdr, struct pbuf *p, const ip_addr_t *addr, u16 port)
 {
+	// Queue a part of a puzzle from a coordinator, it is solved like any other puzzle but only over its range of first tiles
+	u32 id = PROTO_GET_U32(hdr + 1);
+	u8 size = hdr[5];
+
+	// A fragment being put together would share the slot, the coordinator re-issues rejected jobs so refuse this instead
+	job_t *job = frag_job ? NULL : job_queue_reserve(&job_queue);
+	if (!job || size < 2 || size > MAX_SIZE || hdr[6] >= hdr[7] || hdr[7] > size * size ||
+			!decode_tiles(p, JOB_HEADER_LEN, job->puzzle.tiles, size * size))
+	{
+		send_job_done(addr, port, id, 0, JOB_REJECTED, 0);
+		return;
+	}
 
-    tile_t tile = {
-		// Top
-		((u8 *)(&data))[0],
-		// Bottom
-        ((u8 *)(&data))[2],
-		// Left
-        ((u8 *)(&data))[3],
-		// Right
-        ((u8 *)(&data))[1]
-    };
-    return tile;
+	job->seed = id;
+	ip_addr_copy(job->from, *addr);
+	job->from_port = port;
+	job->cluster = 1;
+	job->start_idx = hdr[6];
+	job->end_idx = hdr[7];
+	job->puzzle.size = size;
+	job_queue_push(&job_queue);
 }
 
-puzzle_t make_puzzle(u8 size, u32 *data)
+void handle_config(struct pbuf *p, const ip_addr_t *addr, u16 port)
 {
-    puzzle_t puzzle;
-    puzzle.size = size;
-    // For all tiles make the tile and store it
-    for (int i = 0; i < size * size; i++)
-        puzzle.tiles[i] = make_tile(data[i]);
-    return puzzle;
+	// The command is text after the header, in the same form as typed after a ':' on the console
+	char cmd[CONFIG_MAX_LEN + 1];
+	u16 len = pbuf_copy_partial(p, cmd, CONFIG_MAX_LEN, 1);
+	cmd[len] = '\0';
+
+	xil_printf("Config: %s\r\n", cmd);
+	config_ack[0] = CONFIG_ACK_HEADER;
+	config_ack[1] = net_config_command(cmd) == 0 ? CONFIG_OK : CONFIG_BAD;
+	net_send(addr, port, config_ack, CONFIG_ACK_LEN);
 }
 
 void udp_get_handler(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
 {
     if(p) {
-        u8 *data = p->payload;
-        switch (data[0])
+        // Copy out the header, it is at most FRAG_HEADER_LEN bytes and may be split across pbufs
+        // Headers that are too short for their type are dropped below
+        u8 data[FRAG_HEADER_LEN];
+        u16 len = pbuf_copy_partial(p, data, sizeof(data), 0);
+        u32 queued = job_queue_count(&job_queue);
+        switch (len ? data[0] : 0)
         {
             case RESP_HEADER:
-            {
-                u8 size = data[1];
-                // Output seed and size information
-                xil_printf("size: %u, seed: %u\r\n", size, *((u32 *)(data + 2)));
-                // Make the puzzle and display, then set the state to run the puzzle
-                current_puzzle = make_puzzle(size, (u32 *)(data + 6));
-                display_puzzle(current_puzzle.tiles, size);
-                state = RUNNING;
+            	if (len >= RESP_HEADER_LEN && data[1] > 1 && data[1] <= MAX_SIZE)
+            		handle_puzzles(data[1], PROTO_GET_U32(data + 2), 1, 0, p, RESP_HEADER_LEN, addr, port);
                 break;
-            }
+
+            case BATCH_RESP_HEADER:
+            	if (len >= BATCH_RESP_HEADER_LEN && data[1] > 1 && data[1] <= MAX_SIZE)
+            		handle_puzzles(data[1], PROTO_GET_U32(data + 3), data[2], PROTO_GET_U16(data + 7), p, BATCH_RESP_HEADER_LEN, addr, port);
+            	break;
+
+            case FRAG_HEADER:
+            	// Puzzles bigger than the solvers can take are never asked for so are dropped here
+            	if (len >= FRAG_HEADER_LEN && data[1] > 1 && data[1] <= MAX_SIZE)
+            		handle_fragment(data[1], PROTO_GET_U32(data + 2), PROTO_GET_U16(data + 6), PROTO_GET_U16(data + 8), PROTO_GET_U16(data + 10),
+            			p, FRAG_HEADER_LEN, addr, port);
+            	break;
         
+            case HELLO_HEADER:
+            	send_advertise(addr, port);
+            	break;
+
+            case JOB_HEADER:
+            	if (len >= JOB_HEADER_LEN)
+            		handle_job(data, p, addr, port);
+            	break;
+
+            case CONFIG_HEADER:
+            	handle_config(p, addr, port);
+            	break;
+
             default:
-            	xil_printf("unknown: %s\r\n", data);
+            	xil_printf("unknown: 0x%02x, %u bytes\r\n", data[0], p->tot_len);
             	break;
         }
 
+        if (!boot_reported && job_queue_count(&job_queue) > queued)
+        {
+            boot_stage("first puzzle");
+            boot_report();
+        }
+
         // Free the buffer when no longer needed
         pbuf_free(p);
     }
 }
  
-void request_puzzle(u8 size, u32 seed)
+void send_request(void *payload, u16 len)
 {
-	// Log the information about the request
-    xil_printf("Requesting puzzle of size %u with seed %u.\r\n", size, seed);
-    struct udp_pcb *send_pcb = udp_new();
-    // Build the payload to send
-    req.req_header = 0x01;
-    req.size = size;
-    *((u32 *)req.seed) = seed;
-
-    // Create the buffer and assign the payload and lengths
-    struct pbuf *buf = pbuf_alloc(PBUF_TRANSPORT, 6, PBUF_REF);
-    buf->payload = &req;
-    buf->len = 6;
-    // Send the data to the server
-    ip_addr_t ip;
-    IP4_ADDR(&ip, 192, 168, 10, 1);
-    err_t err = udp_sendto(send_pcb, buf, &ip, 51050);
-    switch (err)
-    {
-        case ERR_OK:
-            break;
-        default:
-            xil_printf("Network Error\r\n");
-            break;
-    }
-
-
-    // Free the network information when done
-    pbuf_free(buf);
-    udp_remove(send_pcb);
+    // Requests go to each of the configured puzzle servers in turn
+    const net_endpoint_t *server = net_config_next_server();
+    net_send(&server->addr, server->port, payload, len);
 }
 
-void display_tile(tile_t* tile, u8 size, u32 idx)
+void send_result(tile_t *tiles, u32 index)
 {
-    // Get parameters from display controller struct
-	int init_x, init_y;
-	u32 stride = dispCtrl.stride / 4;
-	u32 height = dispCtrl.vMode.height;
-	u32 *frame = (u32 *)dispCtrl.framePtr[dispCtrl.curFrame];
+	// Send a solution back to the host the puzzle came from, this is much quicker than printing it over the UART
+	// Solutions to a part of a puzzle from a coordinator are sent with the job id instead of the seed
+	u32 count = current_puzzle->size * current_puzzle->size;
 
-	u32 tile_size = (height / size) - 5;
+	if (current_job->cluster)
+	{
+		result_buf[0] = JOB_RESULT_HEADER;
+		PROTO_PUT_U32(result_buf + 1, current_job->seed);
+		result_buf[5] = current_puzzle->size;
+	}
+	else
+	{
+		result_buf[0] = RESULT_HEADER;
+		result_buf[1] = current_puzzle->size;
+		PROTO_PUT_U32(result_buf + 2, current_seed);
+	}
+	result_buf[6] = index;
+	PROTO_PUT_U32(result_buf + 7, platform_time_us() - solve_start_us);
 
-    init_x = (idx % size) * (height / size) + 5;
-    init_y = (idx / size) * (height / size) + 5;
+	// Tiles go back in the order they are recieved in, top, right, bottom then left
+	u8 *out = result_buf + RESULT_HEADER_LEN;
+	for (u32 i = 0; i < count; i++)
+	{
+		*out++ = tiles[i].top;
+		*out++ = tiles[i].right;
+		*out++ = tiles[i].bottom;
+		*out++ = tiles[i].left;
+	}
 
-    int x = init_x;
-    int y = init_y;
+	net_send(&current_job->from, current_job->from_port, result_buf, RESULT_HEADER_LEN + count * PROTO_TILE_LEN);
+}
 
-    // Display top triabgle
-    for (int height = 0; height < (tile_size / 2); height++)
-    {
-        for (int width = 0; width < (tile_size - (height * 2)); width++)
-        {
-            frame[(y+height)*stride+(x+height+width)] = get_color(tile->top);
-        }
-    }
+void send_summary(u32 solutions, u8 flags, u32 time_us)
+{
+	// Lets the host know the puzzle is finished and how it went
+	if (current_job->cluster)
+	{
+		send_job_done(&current_job->from, current_job->from_port, current_job->seed, solutions, flags, time_us);
+		return;
+	}
 
+	summary.header = SUMMARY_HEADER;
+	summary.size = current_puzzle->size;
+	PROTO_PUT_U32(summary.seed, current_seed);
+	PROTO_PUT_U16(summary.solutions, solutions);
+	summary.flags = flags;
+	PROTO_PUT_U32(summary.time, time_us);
 
-    // Display right triangle
-    for (int width = 0; width < (tile_size / 2); width++)
-    {
-        for (int height = 0; height < (tile_size - (width * 2)); height++)
-        {
-            frame[(y+height+width)*stride+(x+(tile_size-width))] = get_color(tile->right);
-        }
-    }
-
+	net_send(&current_job->from, current_job->from_port, &summary, SUMMARY_LEN);
+}
 
-    // Display bottom triangle
-    for (int height = 0; height < (tile_size / 2); height++)
-    {
-        for (int width = 0; width < (tile_size - (height * 2)); width++)
-        {
-            frame[(y+(tile_size-height - 1))*stride+(x+height+width)] = get_color(tile->bottom);
-        }
-    }
+void send_advertise(const ip_addr_t *ip, u16 port)
+{
+	// Tell a coordinator how many more jobs we can take, room is kept for the puzzles already asked for
+	u32 queued = job_queue_count(&job_queue) - (current_puzzle ? 1 : 0);
+	u32 free = job_queue_free(&job_queue);
+	free = free > batch_outstanding + (frag_job ? 1 : 0) ? free - batch_outstanding - (frag_job ? 1 : 0) : 0;
+
+	advertise.header = ADVERTISE_HEADER;
+	advertise.free = free;
+	advertise.cores = solver_count;
+	advertise.queued = queued;
+	net_send(ip, port, &advertise, ADVERTISE_LEN);
+}
 
+void send_job_done(const ip_addr_t *ip, u16 port, u32 id, u32 solutions, u8 flags, u32 time)
+{
+	job_done.header = JOB_DONE_HEADER;
+	PROTO_PUT_U32(job_done.id, id);
+	PROTO_PUT_U16(job_done.solutions, solutions);
+	job_done.flags = flags;
+	PROTO_PUT_U32(job_done.time, time);
+	net_send(ip, port, &job_done, JOB_DONE_LEN);
+}
 
-    // Display left triangle
-    for (int width = 0; width < (tile_size / 2); width++)
-    {
-        for (int height = 0; height < (tile_size - (width * 2)); height++)
-        {
-            frame[(y+height+width)*stride+(x+width)] = get_color(tile->left);
-        }
-    }
+void request_puzzle(u8 size, u32 seed)
+{
+	// Log the information about the request
+    xil_printf("Requesting puzzle of size %u with seed %u.\r\n", size, seed);
+    req.req_header = REQ_HEADER;
+    req.size = size;
+    PROTO_PUT_U32(req.seed, seed);
+    send_request(&req, sizeof(req));
+}
 
+void request_batch(u8 size, u32 seed, u8 count, u16 id)
+{
+	// Log the information about the request
+    xil_printf("Requesting %u puzzles of size %u with seeds from %u.\r\n", count, size, seed);
+    batch_req.req_header = BATCH_REQ_HEADER;
+    batch_req.size = size;
+    PROTO_PUT_U32(batch_req.seed, seed);
+    batch_req.count = count;
+    PROTO_PUT_U16(batch_req.id, id);
+    send_request(&batch_req, sizeof(batch_req));
 }
 
-u32 get_color(u8 color)
+void resend_request(request_t *r)
 {
-	// This switch statement gets the pixel colour information from the colour information from the server
-    switch (color)
-    {
-        case RED_CODE:
-            return RED;
-        case GREEN_CODE:
-            return GREEN;
-        case BLUE_CODE:
-            return BLUE;
-        case YELLOW_CODE:
-            return YELLOW;
-        case MAGENTA_CODE:
-            return MAGENTA;
-        case CYAN_CODE:
-            return CYAN;
-        case WHITE_CODE:
-            return WHITE;
-        case PURPLE_CODE:
-            return PURPLE;
-        case ORANGE_CODE:
-            return ORANGE;
-        case LIME_CODE:
-            return LIME;
-        default:
-            return 0;
-    }
+	// Ask again for only the puzzles still missing, with the same id so the replies still match
+	// send_request() moves on to the next server so a server that has gone away is worked around
+	u32 first = 0, last = r->count - 1;
+	while (r->have & (1u << first))
+		first++;
+	while (r->have & (1u << last))
+		last--;
+
+	if (r->count == 1)
+		request_puzzle(r->size, r->seed);
+	else
+		request_batch(r->size, r->seed + first, last - first + 1, r->id);
 }
 
-void display_puzzle(tile_t* puzzle, uint32_t size)
+void poll_events()
 {
-	int x, y;
-	u32 stride = dispCtrl.stride / 4;
-	u32 width = dispCtrl.vMode.width;
-	u32 height = dispCtrl.vMode.height;
-	u32 *frame = (u32 *)dispCtrl.framePtr[dispCtrl.curFrame];
+	// The one place the network is serviced, from both the main loop and while solving
+	// Note when the network has an address, any requests waiting for it are then sent by pump_requests()
+	static u8 net_ready = 0;
+	if (!net_ready && platform_net_ready())
+	{
+		net_ready = 1;
+		boot_stage("address");
+	}
+
+	net_poll();
+	pump_requests();
 
-	// Fill the screen with a grey background
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			frame[y*stride + x] = (0x44 << BIT_DISPLAY_RED) | (0x44 << BIT_DISPLAY_GREEN) | (0x44 << BIT_DISPLAY_BLUE);
+	// Telemetry is sent from here too so it keeps going while a puzzle is being solved
+	if (net_ready)
+		stats_poll(job_queue_count(&job_queue) - (current_puzzle ? 1 : 0), state == RUNNING);
+}
+
+void pump_requests()
+{
+	// Keep up to PREFETCH_DEPTH requests in flight as long as there is room in the queue for the replies
+	// This means the next puzzle is normally already waiting when the solvers finish
+	if (!platform_net_ready())
+		return;
+
+	// Requests that haven't been answered in time are sent again, backing off each time
+	// After REQUEST_MAX_TRIES the missing puzzles are given up on so the batch still finishes
+	u32 now = platform_time_us();
+	request_t *r;
+	while ((r = request_due(&requests, now)))
+	{
+		if (r->tries >= REQUEST_MAX_TRIES)
+		{
+			u32 missing = request_missing(r);
+			xil_printf("No reply from the server, gave up on %u puzzles from seed %u\r\n", missing, r->seed);
+			batch_outstanding -= missing;
+			request_free(r);
+		}
+		else
+		{
+			resend_request(r);
+			request_sent(r, now);
 		}
 	}
 
+	while (batch_to_request > 0 && batch_outstanding < PREFETCH_DEPTH &&
+			batch_outstanding < job_queue_free(&job_queue) && request_table_free(&requests) > 0)
+	{
+		// Ask for as many as there is room for in one request, small puzzles then arrive several to a datagram
+		u32 count = 1;
+#if USE_BATCH_REQUESTS
+		count = PREFETCH_DEPTH - batch_outstanding;
+		if (count > job_queue_free(&job_queue) - batch_outstanding)
+			count = job_queue_free(&job_queue) - batch_outstanding;
+		if (count > batch_to_request)
+			count = batch_to_request;
+		if (count > BATCH_MAX_COUNT)
+			count = BATCH_MAX_COUNT;
+		if (count > REQUEST_MAX_COUNT)
+			count = REQUEST_MAX_COUNT;
+#endif
+		r = request_add(&requests, input_size, batch_next_seed, count, now);
+		if (count == 1)
+			request_puzzle(input_size, batch_next_seed);
+		else
+			request_batch(input_size, batch_next_seed, count, r->id);
+		batch_next_seed += count;
+		batch_to_request -= count;
+		batch_outstanding += count;
+	}
+}
+
+void cancel_batch()
+{
+	// Stop requesting and throw away any puzzles that are waiting, the current one is kept so it can still be looked at
+	batch_to_request = 0;
+	batch_outstanding = 0;
+	request_table_clear(&requests);
+	frag_job = NULL;
+	// A coordinator is told about any of its jobs that are thrown away so it can give them to another board
+	while (job_queue_count(&job_queue) > (current_puzzle ? 1 : 0))
+	{
+		job_t *job = job_queue_peek_last(&job_queue);
+		if (job->cluster)
+			send_job_done(&job->from, job->from_port, job->seed, 0, JOB_REJECTED, 0);
+		job_queue_drop_last(&job_queue);
+	}
+}
 
-	// Display all of the tiles
-	for (int i = 0; i < size * size; i++)
+u8 start_next_job(u8 draw)
+{
+	// The previous job stays at the front of the queue until there is another to replace it
+	// so that its solutions can still be looked at
+	// draw is 0 when the puzzle is only being reported and the caller draws whatever is shown last
+	if (current_puzzle)
 	{
-		display_tile(puzzle + i, size, i);
+		if (job_queue_count(&job_queue) < 2)
+			return 0;
+		job_queue_pop(&job_queue);
 	}
 
-	// Flush the video buffer
-    Xil_DCacheFlush();
+	job_t *job = job_queue_peek(&job_queue);
+	if (!job)
+		return 0;
+
+	current_job = job;
+	current_puzzle = &job->puzzle;
+	current_seed = job->seed;
+
+	// Output seed and size information and display the puzzle if asked to
+	if (job->cluster)
+		xil_printf("size: %u, job: %u, tiles %u-%u\r\n", current_puzzle->size, current_seed, job->start_idx, job->end_idx - 1);
+	else
+		xil_printf("size: %u, seed: %u, queued: %u\r\n", current_puzzle->size, current_seed, job_queue_count(&job_queue) - 1);
+	sol_buf_size = 0;
+	if (draw)
+		display_puzzle(current_puzzle->tiles, current_puzzle->size);
+	return 1;
+}
+
+void display_puzzle(tile_t* puzzle, uint32_t size)
+{
+	// Work out where everything goes for this size then draw the puzzle and make sure it reaches the screen
+	layout_compute(&layout, display.surface.width, display.surface.height, size);
+	render_puzzle(&display.surface, &layout, puzzle);
+	display_panel();
+}
+
+void display_panel()
+{
+	// Only redraw the side panel, this is cheap enough to do whenever the solver stats change
+	if (!current_puzzle)
+		return;
+
+	panel_info_t info = {
+		.size = current_puzzle->size,
+		.seed = current_seed,
+		.sol_idx = sol_buf_size ? sol_buf_idx : -1,
+		.sol_count = sol_buf_size,
+		.solvers_running = solvers_running,
+		.solver_count = solver_count
+	};
+	render_panel(&display.surface, &layout, &info);
+	display_flush(&display);
 }
 
 void init_hdmi()
 {
-    // Initialise an array of pointers to the 2 frame buffers
-	int i;
-	for (i = 0; i < DISPLAY_NUM_FRAMES; i++)
-		pFrames[i] = frameBuf[i];
-
-    // Initialise the display controller
-	DisplayInitialize(&dispCtrl, XPAR_AXIVDMA_0_DEVICE_ID, XPAR_VTC_0_DEVICE_ID, XPAR_HDMI_AXI_DYNCLK_0_BASEADDR, pFrames, FRAME_STRIDE);
-
-	// Use first frame buffer (of two)
-	DisplayChangeFrame(&dispCtrl, 0);
-
-	// Set the display resolution
-	DisplaySetMode(&dispCtrl, &VMODE_1440x900);
-
-	// Enable video output
-	DisplayStart(&dispCtrl);
-
-	printf("\n\r");
-	printf("HDMI output enabled\n\r");
-	printf("Current Resolution: %s\n\r", dispCtrl.vMode.label);
-	printf("Pixel Clock Frequency: %.3fMHz\n\r", dispCtrl.pxlFreq);
-	printf("Drawing gradient pattern to screen...\n\r");
-
-	// Get parameters from display controller struct
-	int x, y;
-	u32 stride = dispCtrl.stride / 4;
-	u32 width = dispCtrl.vMode.width;
-	u32 height = dispCtrl.vMode.height;
-	u32 *frame = (u32 *)dispCtrl.framePtr[dispCtrl.curFrame];
-	u32 red, green, blue;
-
-	// Fill the screen with a nice gradient pattern
-	for (y = 0; y < height; y++) {
-		for (x = 0; x < width; x++) {
-			green = (x*0xFF) / width;
-			blue = 0xFF - ((x*0xFF) / width);
-			red = (y*0xFF) / height;
-			frame[y*stride + x] = (red << BIT_DISPLAY_RED) | (green << BIT_DISPLAY_GREEN) | (blue << BIT_DISPLAY_BLUE);
-		}
-	}
+	palette_init();
 
-	// Flush the cache, so the Video DMA core can pick up our frame buffer changes.
-	// Flushing the entire cache (rather than a subset of cache lines) makes sense as our buffer is so big
-	Xil_DCacheFlush();
+	if (display_init(&display, &DISPLAY_MODE) != XST_SUCCESS)
+	{
+		xil_printf("Error initialising HDMI output\r\n");
+		return;
+	}
 
-	printf("Done.\n\r");
+#if BOOT_SPLASH
+	// The full gradient test pattern is too slow for boot, it can still be drawn with 'g'
+	render_splash(&display.surface, "WAITING FOR PUZZLE");
+	display_flush(&display);
+#endif
 }
 
 void print_puzzle(tile_t *tiles, uint32_t size)
@@ -390,24 +780,39 @@ uint8_t traverse_puzzles(char byte)
 	{
 		char_buffer_idx = 0;
 		char_buffer[0] = '\0';
+		// Aborting also stops the rest of the batch
+		cancel_batch();
 		return 1;
 	}
 	else if (byte == 'p')
 	{
-		if (sol_buf_idx >= 0)
+		if (current_puzzle && sol_buf_idx >= 0)
 		{
 			sol_buf_idx--;
 			if (sol_buf_idx == -1)
-				display_puzzle(current_puzzle.tiles, current_puzzle.size);
+				display_puzzle(current_puzzle->tiles, current_puzzle->size);
 			else
-				display_puzzle((tile_t *)sol_buf[sol_buf_idx], current_puzzle.size);
+				display_puzzle((tile_t *)sol_buf[sol_buf_idx], current_puzzle->size);
 		}
 	} else if (byte == 'n')
 	{
-		if (sol_buf_idx < (sol_buf_size - 1))
+		if (current_puzzle && sol_buf_idx < (sol_buf_size - 1))
 		{
-			display_puzzle((tile_t *)sol_buf[++sol_buf_idx], current_puzzle.size);
+			display_puzzle((tile_t *)sol_buf[++sol_buf_idx], current_puzzle->size);
 		}
+	} else if (byte == 'v')
+	{
+		verbose = !verbose;
+		xil_printf("verbose %s\r\n", verbose ? "on" : "off");
+	} else if (byte == 'f')
+	{
+		first_solution = !first_solution;
+		xil_printf("first solution mode %s\r\n", first_solution ? "on" : "off");
+	} else if (byte == 'g')
+	{
+		// Draw the gradient test pattern to check the display
+		render_gradient(&display.surface);
+		display_flush(&display);
 	}
 
 	return 0;
@@ -428,12 +833,42 @@ u8 puzzle_eq(tile_t *p1, tile_t *p2, u8 size)
 	return 1;
 }
 
+u8 puzzle_eq_turned(tile_t *p1, tile_t *p2, u8 size)
+{
+	// Check if 2 solutions are equal with p1 turned any number of quarter turns, which is the same solution
+	for (u8 r = 0; r < 4; r++)
+	{
+		u8 eq = 1;
+		for (u8 y = 0; y < size && eq; y++)
+		{
+			for (u8 x = 0; x < size && eq; x++)
+			{
+				// Where the tile ends up and which way round once the whole grid is turned r times
+				tile_t t = p1[y * size + x];
+				u8 nx = x, ny = y;
+				for (u8 i = 0; i < r; i++)
+				{
+					u8 tmp = nx;
+					nx = size - 1 - ny;
+					ny = tmp;
+					t = tile_rotate(t);
+				}
+				eq = puzzle_eq(&t, &p2[ny * size + nx], 1);
+			}
+		}
+		if (eq)
+			return 1;
+	}
+	return 0;
+}
+
 u8 is_sol_unique(tile_t *p)
 {
 	// Check to see if a solution is unique in the buffer of solutions
+	u32 hash = solution_hash(p, current_puzzle->size);
 	for (int8_t i = 0; i < sol_buf_size; i++)
 	{
-		if (puzzle_eq(p, (tile_t *)sol_buf[i], current_puzzle.size))
+		if (sol_hash[i] == hash && puzzle_eq_turned(p, (tile_t *)sol_buf[i], current_puzzle->size))
 			return 0;
 	}
 	return 1;
@@ -442,7 +877,7 @@ u8 is_sol_unique(tile_t *p)
 u8 all_done(u8 *arr)
 {
 	// Return whether all of the solvers have completed
-	for (int i = 0; i < SOLVER_COUNT; i++)
+	for (int i = 0; i < solver_count; i++)
 	{
 		if (arr[i] == 0)
 			return 0;
@@ -451,151 +886,572 @@ u8 all_done(u8 *arr)
 	return 1;
 }
 
+void shuffle_tiles(tile_t *t, u32 count, u32 seed)
+{
+	// Put the tiles in a random order and turn each a random number of times
+	// The solvers try tiles in the order they are in memory, so solvers given different seeds search in different orders
+	u32 x = seed * 2654435761u | 1;
+	for (u32 i = count - 1; i > 0; i--)
+	{
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		u32 j = x % (i + 1);
+		tile_t tmp = t[i];
+		t[i] = t[j];
+		t[j] = tmp;
+		for (u32 r = x >> 30; r > 0; r--)
+			t[i] = tile_rotate(t[i]);
+	}
+}
+
+u32 luby(u32 i)
+{
+	// The i'th number of 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., counting from 1
+	// Each block is the sequence so far repeated then the next power of 2
+	while (1)
+	{
+		u32 k = 1;
+		while ((1u << k) - 1 < i)
+			k++;
+		if ((1u << k) - 1 == i)
+			return 1u << (k - 1);
+		i -= (1u << (k - 1)) - 1;
+	}
+}
+
+void restart_solver(int i)
+{
+	// Start the whole search again with the next budget and a new order for the tiles
+	// The core's seed only reorders the tiles after the first, so the shuffle in memory changes each time too
+	// otherwise every restart would make the same first choice, the one most worth getting away from
+	// The seed is never 0 as that would give the tiles in ram order
+	restarts[i]++;
+	u16 seed = (current_seed * 40503u + i * 977u + restarts[i] * 7919u) & 0xFFFF;
+	hal_core_set_search(solver_cores[i], luby(restarts[i]) * RESTART_NODES, seed ? seed : 1);
+	start_solver(i, 0, current_puzzle->size * current_puzzle->size, current_seed + i + restarts[i] * 7919u);
+}
+
+void start_solver(int i, u8 first, u8 end, u32 shuffle)
+{
+	// Search from first tiles first to end - 1, the core overwrites its ram with each solution so the puzzle is copied in every time
+	// A non zero shuffle seed searches the tiles in a different order, a solution is then still a solution to the puzzle
+	memcpy(solver_ram[i].tiles, current_puzzle->tiles, current_puzzle->size * current_puzzle->size * sizeof(tile_t));
+	if (shuffle)
+		shuffle_tiles(solver_ram[i].tiles, current_puzzle->size * current_puzzle->size, shuffle);
+	hal_cache_flush(&solver_ram[i], sizeof(solver_ram_t));
+
+	hal_core_set_reset(solver_cores[i], 1);
+	hal_core_setup(solver_cores[i], current_puzzle->size, first, end);
+	hal_core_start(solver_cores[i]);
+	stats_core_start(i);
+}
+
+u8 puzzle_feasible(puzzle_t *p)
+{
+	// Every edge inside the grid pairs two edges of the same colour and only the 4 * size edges around the outside
+	// are left unpaired, so a colour used an odd number of times needs one of those
+	// More odd colours than outside edges means no layout can work, whatever the search does
+	u16 count[256];
+	memset(count, 0, sizeof(count));
+	for (u32 i = 0; i < p->size * p->size; i++)
+	{
+		count[p->tiles[i].top]++;
+		count[p->tiles[i].bottom]++;
+		count[p->tiles[i].left]++;
+		count[p->tiles[i].right]++;
+	}
+
+#ifdef PACKED_TILES
+	// Cores built with PACKED_TILES hold each edge in 5 bits, so they can't search a puzzle with colours of 32 or more
+	for (u32 c = 32; c < 256; c++)
+		if (count[c])
+			return 0;
+#endif
+
+	u32 odd = 0;
+	for (u32 c = 0; c < 256; c++)
+		odd += count[c] & 1;
+	return odd <= 4 * p->size;
+}
+
+u8 add_solution(tile_t *grid, u8 to_filter)
+{
+	// Keep a solution if it is new, returns 1 once the buffer is full and the search should be aborted
+	// to_filter is 0 when no solver is searching the puzzle any more, so the filter is left alone
+	// and nothing is drawn as the batch being reported draws only its last puzzle
+	if (sol_buf_size == MAX_BUF_SIZE || !is_sol_unique(grid))
+		return sol_buf_size == MAX_BUF_SIZE;
+
+	xil_printf("Found solution: %u\r\n", sol_buf_size + 1);
+	memcpy(sol_buf[sol_buf_size], grid, MAX_SIZE * MAX_SIZE * sizeof(uint32_t));
+	if (verbose)
+		print_puzzle((tile_t *)sol_buf[sol_buf_size], current_puzzle->size);
+
+	// Add it to the filter so the solver cores don't send it back again, a core that reads the filter
+	// before this reaches memory just sends a duplicate that is dropped above
+	u32 hash = solution_hash(grid, current_puzzle->size);
+	sol_hash[sol_buf_size] = hash;
+	if (to_filter)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			u32 bit = (hash >> (i * 10)) & (SOLUTION_FILTER_BITS - 1);
+			sol_filter[bit >> 5] |= 1u << (bit & 31);
+		}
+		sol_filter[SOLUTION_FILTER_HASHES + sol_buf_size] = hash;
+		sol_filter[SOLUTION_FILTER_COUNT] = sol_buf_size + 1;
+		hal_cache_flush(sol_filter, sizeof(sol_filter));
+	}
+	sol_buf_size++;
+	stats.solutions++;
+	send_result((tile_t *)sol_buf[sol_buf_size - 1], sol_buf_size);
+
+	// If it is the first solution the display it
+	// If it is the last solution then abort the hardware solvers
+	if (sol_buf_size == 1 && to_filter)
+		display_puzzle((tile_t *)sol_buf[0], current_puzzle->size);
+	return sol_buf_size == MAX_BUF_SIZE;
+}
+
+u32 batch_jobs()
+{
+	// How many of the jobs from the front of the queue can be solved as a batch, first solution mode races
+	// every solver on one puzzle and a coordinator's job is only a part of one so neither are batched
+	if (solver_count == 0 || first_solution)
+		return 0;
+	u32 count = 0;
+	job_t *job;
+	while (count < solver_count * BATCH_PER_CORE && (job = job_queue_at(&job_queue, count)) != NULL
+			&& !job->cluster && job->puzzle.size <= BATCH_MAX_SIZE)
+		count++;
+	return count;
+}
+
+u8 solve_batch(u32 count)
+{
+	// Only solvers that initialise are dealt puzzles, with none the puzzles are left to be solved one at a time
+	u8 usable[HAL_MAX_CORES];
+	u32 usable_count = 0;
+	for (int i = 0; i < solver_count; i++)
+	{
+		if (hal_core_init(solver_cores[i], solver_ram[i].tiles, sol_filter) == XST_SUCCESS)
+			usable[usable_count++] = i;
+		else
+			xil_printf("Solver %u is not responding, it is left out of this batch\r\n", i);
+	}
+	if (usable_count == 0)
+		return 0;
+
+	// Deal the puzzles out to the solvers in turn, a puzzle that can't be solved isn't given to any
+	// Until a solver says otherwise every puzzle is marked aborted, so one it never got to isn't taken as finished
+	batch_desc_t *descs[JOB_QUEUE_SIZE];
+	u8 per_solver[HAL_MAX_CORES];
+	memset(per_solver, 0, sizeof(per_solver));
+	u32 next = 0;
+	for (u32 k = 0; k < count; k++)
+	{
+		job_t *job = job_queue_at(&job_queue, k);
+		descs[k] = NULL;
+		if (!puzzle_feasible(&job->puzzle))
+			continue;
+
+		u32 i = usable[next++ % usable_count];
+		batch_desc_t *desc = &batch_descs[i][per_solver[i]++];
+		desc->size = job->puzzle.size;
+		desc->solutions = 0;
+		desc->flags = BATCH_ABORTED;
+		memcpy(desc->tiles, job->puzzle.tiles, sizeof(desc->tiles));
+		descs[k] = desc;
+	}
+
+	xil_printf("Solving %u puzzles as a batch\r\n", count);
+	solve_start_us = platform_time_us();
+	u8 done[HAL_MAX_CORES];
+	memset(done, 0, sizeof(done));
+	for (int i = 0; i < solver_count; i++)
+	{
+		done[i] = per_solver[i] == 0;
+		if (done[i])
+			continue;
+		hal_cache_flush(batch_descs[i], per_solver[i] * sizeof(batch_desc_t));
+		hal_core_set_abort(solver_cores[i], 0);
+		hal_core_set_batch(solver_cores[i], batch_descs[i], batch_filters[i].words, per_solver[i]);
+		hal_core_start(solver_cores[i]);
+		stats_core_start(i);
+	}
+	solvers_running = 0;
+	for (int i = 0; i < solver_count; i++)
+		solvers_running += !done[i];
+	display_panel();
+
+	// Each solver only stops once its whole batch is done
+	int aborted = 0;
+	while (!all_done(done))
+	{
+		poll_events();
+		if (hal_console_ready())
+		{
+			char byte = hal_console_read();
+			aborted |= traverse_puzzles(byte);
+		}
+
+		for (int i = 0; i < solver_count; i++)
+		{
+			if (done[i] || !hal_core_done(solver_cores[i]))
+			{
+				hal_core_set_abort(solver_cores[i], aborted);
+				continue;
+			}
+			done[i] = 1;
+			stats_core_stop(i);
+			hal_cache_invalidate(batch_descs[i], per_solver[i] * sizeof(batch_desc_t));
+			solvers_running--;
+			display_panel();
+		}
+	}
+	u32 batch_us = platform_time_us() - solve_start_us;
+	xil_printf("Batch of %u puzzles completed in %u us\r\n", count, batch_us);
+
+	// Report each puzzle in the order they came as if it had been solved on its own
+	// Aborting throws away the rest of the queue so only the first is left to report then
+	// The puzzles weren't timed on their own so each is sent the time of the whole batch and marked as such
+	for (u32 k = 0; k < count; k++)
+	{
+		if (k > 0 && (aborted || !start_next_job(0)))
+			break;
+
+		sol_buf_size = 0;
+		sol_buf_idx = 0;
+		u8 flags = SUMMARY_BATCH;
+		if (!descs[k])
+		{
+			flags |= SUMMARY_INFEASIBLE;
+			xil_printf("Puzzle has no solution, its edge colours can't pair up\r\n");
+		}
+		else
+		{
+			for (u32 j = 0; j < descs[k]->solutions && j < BATCH_MAX_SOLUTIONS; j++)
+				add_solution(descs[k]->solution[j], 0);
+			if (descs[k]->flags & (BATCH_ABORTED | BATCH_FULL))
+				flags |= SUMMARY_ABORTED;
+			if (sol_buf_size == MAX_BUF_SIZE)
+				flags |= SUMMARY_BUF_FULL;
+		}
+		send_summary(sol_buf_size, flags, batch_us);
+		stats.puzzles++;
+		xil_printf("Execution completed! %u solutions\r\n", sol_buf_size);
+	}
+
+	// Redrawing every puzzle in turn would hold up the reports, so only the one left on screen is drawn
+	display_puzzle(sol_buf_size ? (tile_t *)sol_buf[0] : current_puzzle->tiles, current_puzzle->size);
+	return 1;
+}
+
 void solve_puzzle()
 {
+	// Several small puzzles waiting are solved as a batch instead, each on one solver
+	u32 batch = batch_jobs();
+	if (batch > 1 && solve_batch(batch))
+		return;
+
 	// Reset the solution buffer information
 	sol_buf_size = 0;
 	sol_buf_idx = 0;
+	memset(sol_filter, 0, sizeof(sol_filter));
+	hal_cache_flush(sol_filter, sizeof(sol_filter));
+
+	// The job's first tiles are handed out one at a time to whichever solver is free, so no solver is left
+	// with a slow part of the search while the others sit idle
+	u32 next_first = current_job->start_idx;
+	u32 end_first = current_job->end_idx;
+
+	// A job from a coordinator is only a part of the puzzle so it is always searched in full
+	// In first solution mode the first working solver keeps the tiles in the order they came in and the others each shuffle them
+	u8 first_mode = first_solution && !current_job->cluster;
+	u32 total = current_puzzle->size * current_puzzle->size;
 
 	// Default abort to 0;
 	int aborted = 0;
-	for (int i = 0; i < SOLVER_COUNT; i++)
+	// A solver that fails to initialise is left out of this puzzle and tried again on the next
+	// In first solution mode the first that works is the one that searches in order to the end
+	u8 failed[HAL_MAX_CORES];
+	u32 working = 0;
+	int full_solver = -1;
+	for (int i = 0; i < solver_count; i++)
 	{
 		// Make sure the solver is initialised and the ram is set correctly
-		XToplevel_Initialize(&hls[i], i);
-		XToplevel_Set_ram(&hls[i], (int)tiles[i]);
-
-		// Define the start and end index's for this solver
-		int start = (i * (current_puzzle.size * current_puzzle.size)) / (SOLVER_COUNT);
-		int end = ((i + 1) * (current_puzzle.size * current_puzzle.size)) / (SOLVER_COUNT);
-
-		// Copy the tiles to the ram
-		memcpy(tiles[i], current_puzzle.tiles, MAX_SIZE * MAX_SIZE * sizeof(tile_t));
-
-		// Flush the ram
-		Xil_DCacheFlush();
-
-		// Set the input parameters, specifically make sure the solver is reset
-		XToplevel_Set_reset(&hls[i], 1);
-		XToplevel_Set_in_size(&hls[i], current_puzzle.size);
-		XToplevel_Set_in_start_idx(&hls[i], start);
-		XToplevel_Set_in_end_idx(&hls[i], end);
-		XToplevel_Set_abort(&hls[i], aborted);
+		failed[i] = hal_core_init(solver_cores[i], solver_ram[i].tiles, sol_filter) != XST_SUCCESS;
+		if (failed[i])
+		{
+			xil_printf("Solver %u is not responding, it is left out of this puzzle\r\n", i);
+			continue;
+		}
+		if (full_solver < 0)
+			full_solver = i;
+		working++;
+		hal_core_set_abort(solver_cores[i], aborted);
+		hal_core_set_search(solver_cores[i], 0, 0);
+		restarts[i] = 0;
 	}
+	// In first solution mode any solver that gets through the whole puzzle shows there is no solution, so the rest stop
+	u8 exhausted = 0;
 
-	print_puzzle(current_puzzle.tiles, current_puzzle.size);
+	if (verbose)
+		print_puzzle(current_puzzle->tiles, current_puzzle->size);
 
-	// Start all of the solvers
-	for (int i = 0; i < SOLVER_COUNT; i++)
-		XToplevel_Start(&hls[i]);
+	// Don't start the solvers on a puzzle that can't have a solution, they would search all of it for nothing
+	solve_start_us = platform_time_us();
+	if (!puzzle_feasible(current_puzzle))
+	{
+		// It still finishes like any other puzzle, with the panel showing no solvers running and no solutions
+		solvers_running = 0;
+		display_panel();
+		send_summary(0, SUMMARY_INFEASIBLE, platform_time_us() - solve_start_us);
+		stats.puzzles++;
+		xil_printf("Puzzle has no solution, its edge colours can't pair up\r\n");
+		return;
+	}
 
-	// Set the done array to 0 for all of the solvers
-	u8 done[SOLVER_COUNT] = {0, 0, 0, 0};
+	// Start as many of the solvers as there are first tiles
+	// A job from a coordinator may have fewer first tiles than solvers, the spare solvers are done straight away
+	u8 done[HAL_MAX_CORES];
+	memset(done, 0, sizeof(done));
+	for (int i = 0; i < solver_count; i++)
+	{
+		// One solver always runs to the end so the puzzle is still searched in full if the restarts never get lucky
+		if (failed[i])
+			done[i] = 1;
+		else if (first_mode && i == full_solver)
+			start_solver(i, 0, total, 0);
+		else if (first_mode)
+			restart_solver(i);
+		else if (next_first < end_first)
+			start_solver(i, next_first, next_first + 1, 0), next_first++;
+		else
+			done[i] = 1;
+	}
+	if (first_mode)
+		next_first = end_first;
+#if !SW_SOLVER
+	// Nothing can search the puzzle, so report it as stopped rather than as having no solutions
+	if (working == 0)
+		aborted = 1;
+#endif
+
+#if SW_SOLVER
+	// The software solver searches first tiles that would otherwise be waiting, in the time between polls
+	// sw_first is the first tile it is on, or -1 when it has none
+	int sw_first = -1;
+	if (first_mode)
+	{
+		// It gets its own order of the whole puzzle like the hardware solvers
+		tile_t shuffled[MAX_SIZE * MAX_SIZE];
+		memcpy(shuffled, current_puzzle->tiles, total * sizeof(tile_t));
+		shuffle_tiles(shuffled, total, current_seed + solver_count + 1);
+		sw_solver_reset(&sw_solver, shuffled, current_puzzle->size, 0, total);
+		sw_first = 0;
+		stats_core_start(solver_count);
+	}
+#endif
+	solvers_running = 0;
+	for (int i = 0; i < solver_count; i++)
+		solvers_running += !done[i];
+	display_panel();
 
 	// While there is still a solver running perform this loop
-	while (!all_done(done))
+	// With no hardware solvers the software solver takes every first tile, so also carry on while there are any left
+	while (!all_done(done)
+#if SW_SOLVER
+			|| sw_first >= 0 || (!aborted && next_first < end_first)
+#endif
+			)
 	{
+		// Set when a solver finishes or a solution is found so the side panel gets redrawn
+		u8 panel_dirty = 0;
 
 		// Handle the ethernet so we don't run out of pbuf's
-		handle_ethernet();
+		// This also queues up the next puzzles of the batch while this one is being solved
+		poll_events();
 
 		// If there is data on the serial consume it and perform the relevant action
-		if (XUartPs_IsReceiveData(STDIN_BASEADDRESS))
+		if (hal_console_ready())
 		{
-			char byte = XUartPs_RecvByte(STDIN_BASEADDRESS);
+			char byte = hal_console_read();
 			aborted |= traverse_puzzles(byte);
 		}
 
 		// Check each solver
-		for (int i = 0; i < SOLVER_COUNT; i++)
+		for (int i = 0; i < solver_count; i++)
 		{
-			// If the solver is done the mark it as done
-			if (XToplevel_IsDone(&hls[i]))
+			if (done[i] || !hal_core_done(solver_cores[i]))
 			{
-				done[i] = 1;
-				// If the return value says it has not finished the search space and it's found a solution then...
-				if (XToplevel_Get_return(&hls[i]) && sol_buf_size != MAX_BUF_SIZE)
+				// On each loop set the abort line to the aborted variable
+				hal_core_set_abort(solver_cores[i], aborted || exhausted);
+				continue;
+			}
+
+			panel_dirty = 1;
+			stats_core_stop(i);
+			u8 result = hal_core_result(solver_cores[i]);
+			// Out of budget, which only happens in first solution mode, so try again with a new order
+			if (result == HAL_CORE_BUDGET && !aborted && !exhausted)
+			{
+				restart_solver(i);
+				continue;
+			}
+			if (first_mode && result == HAL_CORE_DONE && !aborted)
+				exhausted = 1;
+			// If the return value says it has not finished its first tile then it has found a solution
+			// In first solution mode a core that finishes after the first solution is only there to be stopped
+			if (result == HAL_CORE_SOLUTION && sol_buf_size != MAX_BUF_SIZE && !(first_mode && aborted))
+			{
+				// Invalidate the cache so that the solution is in memory
+				hal_cache_invalidate(&solver_ram[i], sizeof(solver_ram_t));
+				aborted |= add_solution(solver_ram[i].tiles, 1) || first_mode;
+				if (first_mode)
+					xil_printf("First solution from solver %u in %u us\r\n", i, platform_time_us() - solve_start_us);
+				// If have not aborted then restart the solver where it left off
+				if (!aborted)
 				{
-					// Invalidate the cache so that the solution is in memory
-					Xil_DCacheInvalidateRange((int)tiles[i], MAX_SIZE * MAX_SIZE * sizeof(tile_t));
-					// If the solution is unique then add the solution to the solution buffer
-					if (is_sol_unique(tiles[i]))
-					{
-						xil_printf("Found solution: %u\r\n", sol_buf_size + 1);
-						memcpy(sol_buf[sol_buf_size], tiles[i], MAX_SIZE * MAX_SIZE * sizeof(uint32_t));
-						print_puzzle((tile_t *)sol_buf[sol_buf_size], current_puzzle.size);
-						sol_buf_size++;
-						// If it is the first solution the display it
-						// If it is the last solution then abort the hardware solvers
-						if (sol_buf_size == 1)
-						{
-							display_puzzle((tile_t *)sol_buf[0], current_puzzle.size);
-						}
-						else if (sol_buf_size == MAX_BUF_SIZE)
-						{
-							aborted = 1;
-						}
-					}
-					else
-					{
-						//xil_printf("Not unique\r\n");
-					}
-					// If have not aborted and we know we have search space left then restart the solver and mark it as not done
-					if (!aborted)
-					{
-						XToplevel_Set_reset(&hls[i], 0);
-						XToplevel_Start(&hls[i]);
-						done[i] = 0;
-					}
+					hal_core_set_reset(solver_cores[i], 0);
+					hal_core_start(solver_cores[i]);
+					stats_core_start(i);
+					continue;
 				}
 			}
 
-			// On each loop set the abort line to the aborted variable
-			XToplevel_Set_abort(&hls[i], aborted);
+			// Otherwise it has finished its first tile so give it the next one
+			if (!aborted && next_first < end_first)
+				start_solver(i, next_first, next_first + 1, 0), next_first++;
+#if SW_SOLVER
+			// With none left take over the software solver's, it is far slower so would hold up the whole puzzle
+			// Anything it already found is found again and dropped as a duplicate
+			else if (!aborted && sw_first >= 0 && !first_mode)
+			{
+				start_solver(i, sw_first, sw_first + 1, 0);
+				sw_first = -1;
+				stats_core_stop(solver_count);
+			}
+#endif
+			else
+				done[i] = 1;
+			hal_core_set_abort(solver_cores[i], aborted || exhausted);
+		}
+
+#if SW_SOLVER
+		// Only first tiles the hardware solvers won't get to soon are taken, the last of them are left to the hardware
+		if (sw_first < 0 && !aborted && end_first - next_first > working)
+		{
+			sw_first = next_first++;
+			sw_solver_reset(&sw_solver, current_puzzle->tiles, current_puzzle->size, sw_first, sw_first + 1);
+			stats_core_start(solver_count);
+		}
+		if (sw_first >= 0)
+		{
+			u8 result = aborted || exhausted ? SW_SOLVER_DONE : sw_solver_run(&sw_solver, SW_SOLVER_STEPS);
+			if (result == SW_SOLVER_FOUND)
+			{
+				aborted |= add_solution(sw_solver.grid, 1) || first_mode;
+				if (first_mode)
+					xil_printf("First solution from the software solver in %u us\r\n", platform_time_us() - solve_start_us);
+			}
+			else if (result == SW_SOLVER_DONE)
+			{
+				exhausted |= first_mode && !aborted;
+				sw_first = -1;
+				stats_core_stop(solver_count);
+			}
+		}
+#endif
+
+		if (panel_dirty)
+		{
+			solvers_running = 0;
+			for (int i = 0; i < solver_count; i++)
+				solvers_running += !done[i];
+			display_panel();
 		}
 	}
 
-	// Change the state so that the user can request another puzzle
-	xil_printf("Execution completed!\r\n");
-	state = GET_SIZE;
-	xil_printf("size: ");
+	// Let the host know the puzzle is done, a full buffer also aborts the solvers so both flags are set then
+	u8 flags = 0;
+	if (aborted)
+		flags |= SUMMARY_ABORTED;
+	if (sol_buf_size == MAX_BUF_SIZE)
+		flags |= SUMMARY_BUF_FULL;
+	send_summary(sol_buf_size, flags, platform_time_us() - solve_start_us);
+	stats.puzzles++;
+
+	// Go back to waiting for a puzzle, the main loop starts the next one in the batch or asks for another batch
+	xil_printf("Execution completed! %u solutions in %u us\r\n", sol_buf_size, platform_time_us() - solve_start_us);
 }
 
-int main()
+void print_prompt()
 {
-    init_hdmi();
-
-    ip_addr_t ipaddr, netmask;
-    unsigned char mac_ethernet_address[] = {0x00, 0x11, 0x22, 0x33, 0x00, 0x59}; // Put your own MAC address here!
-
-    init_platform(mac_ethernet_address, &ipaddr, &netmask);
+	// Show what the console is waiting for again, along with anything already typed
+	prompt_state = state;
+	if (state == GET_SIZE)
+		xil_printf("size: %s", char_buffer);
+	else if (state == GET_SEED)
+		xil_printf("seed: %s", char_buffer);
+	else if (state == GET_COUNT)
+		xil_printf("count: %s", char_buffer);
+}
 
-    // Initialise all the solvers
-    for (int i = 0; i < SOLVER_COUNT; i++)
+int main()
+{
+    // Start the timer first so every stage of boot can be timed
+    init_timer();
+    boot_stage("timer");
+
+    // Networking comes up first, with DHCP the lease is waited for in the main loop rather than here
+    // The settings start as the defaults in net_config.h and can be changed once running
+    net_config_init();
+    init_platform(net_config.mac, &net_config.ip, &net_config.netmask, &net_config.gw, net_config.use_dhcp);
+    boot_stage("network");
+
+    // Find the solvers, however many the hardware was built with
+    for (u32 core = 0; core < hal_core_count(); core++)
     {
-        XToplevel_Initialize(&hls[i], i);
-        XToplevel_Set_ram(&hls[i], (int)tiles[i]);
+        if (hal_core_init(core, solver_ram[solver_count].tiles, sol_filter) == XST_SUCCESS)
+            solver_cores[solver_count++] = core;
+        else
+            xil_printf("Solver %u is not responding, it won't be used\r\n", core);
     }
+    xil_printf("%u solvers\r\n", solver_count);
+    boot_stage("solvers");
 
-    // Setup the listner so that we can recieve responses from the server
-    struct udp_pcb *recv_pcb = udp_new();
-    if (!recv_pcb)
-        xil_printf("Error couldn't create recv pcb!");
+    // Setup the listener so that we can recieve responses from the server, everything is also sent from it
+    net_init(udp_get_handler);
+    stats_init(solver_count + SW_SOLVER);
 
-    // Setup listener
-    udp_bind(recv_pcb, IP_ADDR_ANY, 51050);
-    udp_recv(recv_pcb, udp_get_handler, NULL);
+    // The display is only needed once a puzzle arrives so it is brought up last
+    init_hdmi();
+    boot_stage("display");
 
     //Now enter the handling loop
-    xil_printf("size: ");
+    print_prompt();
 
     while(1) {
+        poll_events();
+
     	// If we have data in the serial the consume it and perform the relevant action
-        if (XUartPs_IsReceiveData(STDIN_BASEADDRESS))
+        if (hal_console_ready())
         {
-            char byte = XUartPs_RecvByte(STDIN_BASEADDRESS);
+            char byte = hal_console_read();
             // If return has been pressed then we want to handle the input buffer as required
-            if (byte == '\r')
+            if (byte == '\r' && char_buffer[0] == ':')
+            {
+                // A network setting, these can be changed whenever the console is waiting for input
+                xil_printf("\r\n");
+                if (net_config_command(char_buffer + 1) != 0)
+                    xil_printf("Bad command, try :net, :dhcp, :ip <addr> [<netmask> [<gateway>]], :server <addr[:port]> ..., :server+ <addr[:port]> or :telemetry <addr[:port]> [<ms>]|off\r\n");
+                char_buffer_idx = 0;
+                char_buffer[0] = '\0';
+                print_prompt();
+            }
+            else if (byte == '\r')
             {
                 xil_printf("\r\n");
                 switch (state)
@@ -608,13 +1464,13 @@ int main()
                             char_buffer_idx = 0;
                             char_buffer[0] = '\0';
                             state = GET_SEED;
-                            xil_printf("seed: ");
+                            print_prompt();
                         }
                         else
                         {
-                            xil_printf("size: ");
                             char_buffer_idx = 0;
                             char_buffer[0] = '\0';
+                            print_prompt();
                         }
                         break;
                     case GET_SEED:
@@ -623,21 +1479,36 @@ int main()
                             seed = 0;
                         else
                             seed = atoi(char_buffer);
-                        // We need to convert the seed to little endian
-                        uint32_t seed_tmp;
-                        ((uint8_t *)(&seed_tmp))[0] = ((uint8_t *)(&seed))[3];
-                        ((uint8_t *)(&seed_tmp))[1] = ((uint8_t *)(&seed))[2];
-                        ((uint8_t *)(&seed_tmp))[2] = ((uint8_t *)(&seed))[1];
-                        ((uint8_t *)(&seed_tmp))[3] = ((uint8_t *)(&seed))[0];
-                        seed = seed_tmp;
-
-                        // Reset the char buffer and set the state so that we are expecting to recieve a puzzle
+
+                        char_buffer_idx = 0;
+                        char_buffer[0] = '\0';
+                        state = GET_COUNT;
+                        print_prompt();
+                        break;
+                    case GET_COUNT:
+                    	// The number of consecutive seeds to solve, if nothing is given then just the one
+                    	// Only digits can be typed so it is never negative, but it can be 0 or too long for atoi()
+                        batch_to_request = char_buffer_idx == 0 ? 1 : char_buffer_idx > 9 ? MAX_RUN_COUNT + 1 : atoi(char_buffer);
                         char_buffer_idx = 0;
                         char_buffer[0] = '\0';
+                        if (batch_to_request == 0)
+                        {
+                            xil_printf("The count must be at least 1\r\n");
+                            print_prompt();
+                            break;
+                        }
+                        if (batch_to_request > MAX_RUN_COUNT)
+                        {
+                            xil_printf("At most %u puzzles can be asked for at once, asking for %u\r\n", MAX_RUN_COUNT, MAX_RUN_COUNT);
+                            batch_to_request = MAX_RUN_COUNT;
+                        }
+                        batch_next_seed = seed;
+
+                        // Set the state so that we are expecting to recieve puzzles
+                        // The requests are sent by pump_requests(), as soon as the network is up if it isn't already
                         state = RUN_PUZZLE;
-                        // Request a puzzle with the given parameters from the server
-                        current_puzzle.size = input_size;
-                        request_puzzle(current_puzzle.size, seed);
+                        if (!platform_net_ready())
+                            xil_printf("Waiting for network...\r\n");
                         break;
                     default:
                         break;
@@ -646,8 +1517,18 @@ int main()
             else
             {
             	// If the input is not a number then we want to traverse the current solutions
-            	// Otherwise we add the digit to the char buffer
-                if (byte < '0' || byte > '9')
+            	// Otherwise we add the digit to the char buffer, everything is added once a ':' command has been started
+                if (char_buffer_idx == sizeof(char_buffer) - 1)
+                {
+                    // The buffer is full so anything more is ignored
+                }
+                else if ((byte == ':' && char_buffer_idx == 0) || char_buffer[0] == ':')
+                {
+                    char_buffer[char_buffer_idx++] = byte;
+                    char_buffer[char_buffer_idx] = '\0';
+                    hal_console_write(byte);
+                }
+                else if (byte < '0' || byte > '9')
                 {
                 	traverse_puzzles(byte);
                 }
@@ -655,20 +1536,31 @@ int main()
                 {
                     char_buffer[char_buffer_idx++] = byte;
                 	char_buffer[char_buffer_idx] = '\0';
-                    outbyte(byte);
+                    hal_console_write(byte);
                 }
             }
             
         }
 
-        // If we are in the state to run the puzzle then run it
-        if (state == RUNNING)
+        // Start the next puzzle the moment there is one
+        // Jobs from a coordinator can arrive while the console is waiting for input, that input is carried on with afterwards
+        // The prompt is only shown again if it changed or there is typed input to show, not after every job
+        if (state != RUNNING && start_next_job(1))
         {
-        	solve_puzzle();
+            u8 resume = state;
+            state = RUNNING;
+            solve_puzzle();
+            state = resume;
+            if (state != prompt_state || char_buffer_idx > 0)
+                print_prompt();
         }
 
-        // We always want to handle ethernet if we can!
-        handle_ethernet();
+        // Once the whole batch has been solved go back to asking for a size
+        if (state == RUN_PUZZLE && batch_to_request == 0 && batch_outstanding == 0 && job_queue_count(&job_queue) <= 1)
+        {
+            state = GET_SIZE;
+            print_prompt();
+        }
     }
     return 0;
 }
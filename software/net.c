@@ -0,0 +1,96 @@
+#include <string.h>
+#include "xil_printf.h"
+#include "platform.h"
+#include "net.h"
+
+// An entry in the send pool and where its payload started, lwIP moves the payload back over the headers it adds
+typedef struct {
+    struct pbuf *p;
+    void *payload;
+} net_tx_buf_t;
+
+net_stats_t net_stats;
+
+// The one PCB used for everything, it is bound to PROTO_PORT so replies to anything we send come back to it
+static struct udp_pcb *net_pcb;
+static net_tx_buf_t tx_pool[NET_TX_POOL_SIZE];
+static u32 tx_next;
+static udp_recv_fn net_recv_handler;
+
+static void net_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+    // Count the packet then pass it on, the handler frees it
+    net_stats.rx_packets++;
+    net_recv_handler(arg, pcb, p, addr, port);
+}
+
+int net_init(udp_recv_fn recv)
+{
+    net_pcb = udp_new();
+    if (!net_pcb)
+    {
+        xil_printf("Error couldn't create pcb!\r\n");
+        return XST_FAILURE;
+    }
+
+    net_recv_handler = recv;
+    udp_bind(net_pcb, IP_ADDR_ANY, PROTO_PORT);
+    udp_recv(net_pcb, net_recv, NULL);
+
+    // Allocate the send pool up front, PBUF_TRANSPORT leaves room in front of the payload for the headers
+    for (int i = 0; i < NET_TX_POOL_SIZE; i++)
+    {
+        tx_pool[i].p = pbuf_alloc(PBUF_TRANSPORT, NET_TX_BUF_SIZE, PBUF_RAM);
+        if (!tx_pool[i].p)
+        {
+            xil_printf("Error couldn't allocate send pool!\r\n");
+            return XST_FAILURE;
+        }
+        tx_pool[i].payload = tx_pool[i].p->payload;
+    }
+
+    return XST_SUCCESS;
+}
+
+int net_send(const ip_addr_t *ip, u16 port, const void *payload, u16 len)
+{
+    // Find a pbuf the EMAC has finished with, while it is still being sent the driver holds another reference to it
+    net_tx_buf_t *buf = NULL;
+    for (int i = 0; i < NET_TX_POOL_SIZE && !buf; i++)
+    {
+        net_tx_buf_t *candidate = &tx_pool[(tx_next + i) % NET_TX_POOL_SIZE];
+        if (candidate->p->ref == 1)
+            buf = candidate;
+    }
+
+    if (!buf || len > NET_TX_BUF_SIZE)
+    {
+        net_stats.tx_dropped++;
+        return ERR_MEM;
+    }
+    tx_next = (buf - tx_pool + 1) % NET_TX_POOL_SIZE;
+
+    // Put the payload back where it was allocated, the last send left it pointing at the headers
+    buf->p->payload = buf->payload;
+    buf->p->len = len;
+    buf->p->tot_len = len;
+    memcpy(buf->payload, payload, len);
+
+    err_t err = udp_sendto(net_pcb, buf->p, ip, port);
+    if (err != ERR_OK)
+    {
+        net_stats.tx_dropped++;
+        xil_printf("Network Error\r\n");
+        return err;
+    }
+
+    net_stats.tx_packets++;
+    return ERR_OK;
+}
+
+void net_poll()
+{
+    // Everything the EMAC's receive interrupt has queued is handled in one go
+    // so how often this is called only changes latency, not how many packets get through
+    handle_ethernet();
+}
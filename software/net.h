@@ -0,0 +1,25 @@
+#ifndef __NET_H_
+#define __NET_H_
+
+#include "lwip/udp.h"
+#include "protocol.h"
+
+// Outgoing packets are copied into one of these preallocated pbufs, so sending never allocates
+#define NET_TX_POOL_SIZE 8
+// Every pbuf in the pool is big enough for the largest packet in protocol.h
+#define NET_TX_BUF_SIZE PROTO_MAX_PAYLOAD
+
+// Packet counters, these are never reset
+typedef struct {
+    u32 rx_packets;
+    u32 tx_packets;
+    u32 tx_dropped;     // No pbuf free in the pool or lwIP refused the packet
+} net_stats_t;
+
+extern net_stats_t net_stats;
+
+int net_init(udp_recv_fn recv);
+int net_send(const ip_addr_t *ip, u16 port, const void *payload, u16 len);
+void net_poll();
+
+#endif
@@ -0,0 +1,236 @@
+#include <string.h>
+#include "xil_printf.h"
+#include "platform.h"
+#include "protocol.h"
+#include "net_config.h"
+
+net_config_t net_config;
+
+void net_config_init()
+{
+    // Fill in the compile time defaults, with DHCP if it is built in
+    u8 mac[6] = NET_DEFAULT_MAC;
+    memcpy(net_config.mac, mac, sizeof(mac));
+#if LWIP_DHCP==1
+    net_config.use_dhcp = 1;
+#else
+    net_config.use_dhcp = 0;
+#endif
+    IP4_ADDR(&net_config.ip, 192, 168, 0, 10);
+    NET_DEFAULT_NETMASK(&net_config.netmask);
+    NET_DEFAULT_GATEWAY(&net_config.gw);
+
+    NET_DEFAULT_SERVER_IP(&net_config.servers[0].addr);
+    net_config.servers[0].port = PROTO_PORT;
+    net_config.server_count = 1;
+    net_config.next_server = 0;
+
+    net_config.telemetry_ms = 0;
+}
+
+const net_endpoint_t *net_config_next_server()
+{
+    // Round robin over the servers so the load of generating puzzles is shared
+    const net_endpoint_t *server = &net_config.servers[net_config.next_server];
+    net_config.next_server = (net_config.next_server + 1) % net_config.server_count;
+    return server;
+}
+
+static const char *skip_spaces(const char *s)
+{
+    while (*s == ' ')
+        s++;
+    return s;
+}
+
+// Reads a dotted quad, on success *s is left after it
+static int parse_ip(const char **s, ip_addr_t *ip)
+{
+    u32 parts[4];
+    const char *p = *s;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (*p < '0' || *p > '9')
+            return 0;
+        parts[i] = 0;
+        while (*p >= '0' && *p <= '9')
+            parts[i] = parts[i] * 10 + (*p++ - '0');
+        if (parts[i] > 255 || (i < 3 && *p++ != '.'))
+            return 0;
+    }
+
+    IP4_ADDR(ip, parts[0], parts[1], parts[2], parts[3]);
+    *s = p;
+    return 1;
+}
+
+// Reads an address with an optional :port, the port defaults to the protocol's
+static int parse_endpoint(const char **s, net_endpoint_t *ep)
+{
+    const char *p = *s;
+    if (!parse_ip(&p, &ep->addr))
+        return 0;
+
+    ep->port = PROTO_PORT;
+    if (*p == ':')
+    {
+        u32 port = 0;
+        p++;
+        if (*p < '0' || *p > '9')
+            return 0;
+        while (*p >= '0' && *p <= '9')
+            port = port * 10 + (*p++ - '0');
+        if (port == 0 || port > 65535)
+            return 0;
+        ep->port = port;
+    }
+
+    *s = p;
+    return 1;
+}
+
+static int starts_with(const char **s, const char *word)
+{
+    // Matches a whole word, which has to be followed by a space or the end of the command
+    size_t len = strlen(word);
+    if (strncmp(*s, word, len) != 0 || ((*s)[len] != ' ' && (*s)[len] != '\0'))
+        return 0;
+    *s = skip_spaces(*s + len);
+    return 1;
+}
+
+int net_config_command(const char *cmd)
+{
+    // Commands are the same from the console (after a ':') and in a CONFIG packet
+    //   net                               print the settings
+    //   dhcp                              get an address with DHCP
+    //   ip <addr> [<netmask> [<gateway>]] use a static address
+    //   server <addr[:port]> ...          replace the list of puzzle servers
+    //   server+ <addr[:port]>             add a puzzle server
+    //   telemetry <addr[:port]> [<ms>]    send STATS packets every ms
+    //   telemetry off                     stop sending them
+    const char *s = skip_spaces(cmd);
+
+    if (starts_with(&s, "net"))
+    {
+        net_config_print();
+        return 0;
+    }
+    else if (starts_with(&s, "dhcp"))
+    {
+#if LWIP_DHCP==1
+        net_config.use_dhcp = 1;
+        platform_start_dhcp();
+        return 0;
+#else
+        xil_printf("DHCP is not built in\r\n");
+        return -1;
+#endif
+    }
+    else if (starts_with(&s, "ip"))
+    {
+        ip_addr_t ip = net_config.ip, netmask = net_config.netmask, gw = net_config.gw;
+        if (!parse_ip(&s, &ip))
+            return -1;
+        s = skip_spaces(s);
+        if (*s && !parse_ip(&s, &netmask))
+            return -1;
+        s = skip_spaces(s);
+        if (*s && !parse_ip(&s, &gw))
+            return -1;
+        if (*skip_spaces(s))
+            return -1;
+
+        net_config.ip = ip;
+        net_config.netmask = netmask;
+        net_config.gw = gw;
+        net_config.use_dhcp = 0;
+        platform_set_static(&net_config.ip, &net_config.netmask, &net_config.gw);
+        return 0;
+    }
+    else if (starts_with(&s, "server"))
+    {
+        // Parse them all first so a mistake leaves the old list alone
+        net_endpoint_t servers[NET_MAX_SERVERS];
+        u32 count = 0;
+        while (*s)
+        {
+            if (count == NET_MAX_SERVERS || !parse_endpoint(&s, &servers[count++]))
+                return -1;
+            s = skip_spaces(s);
+        }
+        if (count == 0)
+            return -1;
+
+        memcpy(net_config.servers, servers, count * sizeof(net_endpoint_t));
+        net_config.server_count = count;
+        net_config.next_server = 0;
+        return 0;
+    }
+    else if (starts_with(&s, "server+"))
+    {
+        net_endpoint_t server;
+        if (net_config.server_count == NET_MAX_SERVERS || !parse_endpoint(&s, &server) || *skip_spaces(s))
+            return -1;
+        net_config.servers[net_config.server_count++] = server;
+        return 0;
+    }
+    else if (starts_with(&s, "telemetry"))
+    {
+        if (starts_with(&s, "off"))
+        {
+            if (*s)
+                return -1;
+            net_config.telemetry_ms = 0;
+            return 0;
+        }
+
+        net_endpoint_t dest;
+        u32 ms = NET_DEFAULT_TELEMETRY_MS;
+        if (!parse_endpoint(&s, &dest))
+            return -1;
+        s = skip_spaces(s);
+        if (*s)
+        {
+            ms = 0;
+            while (*s >= '0' && *s <= '9')
+                ms = ms * 10 + (*s++ - '0');
+            if (ms == 0 || *skip_spaces(s))
+                return -1;
+        }
+
+        net_config.telemetry = dest;
+        net_config.telemetry_ms = ms;
+        return 0;
+    }
+
+    return -1;
+}
+
+void net_config_print()
+{
+    xil_printf("MAC     : %02x:%02x:%02x:%02x:%02x:%02x\r\n", net_config.mac[0], net_config.mac[1],
+        net_config.mac[2], net_config.mac[3], net_config.mac[4], net_config.mac[5]);
+    if (net_config.use_dhcp)
+        xil_printf("Address : DHCP\r\n");
+    else
+        xil_printf("Address : %d.%d.%d.%d/%d.%d.%d.%d via %d.%d.%d.%d\r\n",
+            ip4_addr1(&net_config.ip), ip4_addr2(&net_config.ip), ip4_addr3(&net_config.ip), ip4_addr4(&net_config.ip),
+            ip4_addr1(&net_config.netmask), ip4_addr2(&net_config.netmask), ip4_addr3(&net_config.netmask), ip4_addr4(&net_config.netmask),
+            ip4_addr1(&net_config.gw), ip4_addr2(&net_config.gw), ip4_addr3(&net_config.gw), ip4_addr4(&net_config.gw));
+    for (u32 i = 0; i < net_config.server_count; i++)
+    {
+        const ip_addr_t *ip = &net_config.servers[i].addr;
+        xil_printf("Server %u: %d.%d.%d.%d:%u\r\n", i + 1, ip4_addr1(ip), ip4_addr2(ip), ip4_addr3(ip), ip4_addr4(ip),
+            net_config.servers[i].port);
+    }
+    if (net_config.telemetry_ms)
+    {
+        const ip_addr_t *ip = &net_config.telemetry.addr;
+        xil_printf("Stats   : %d.%d.%d.%d:%u every %u ms\r\n", ip4_addr1(ip), ip4_addr2(ip), ip4_addr3(ip), ip4_addr4(ip),
+            net_config.telemetry.port, net_config.telemetry_ms);
+    }
+    else
+        xil_printf("Stats   : off\r\n");
+}
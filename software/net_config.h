@@ -0,0 +1,48 @@
+#ifndef __NET_CONFIG_H_
+#define __NET_CONFIG_H_
+
+#include "lwip/ip_addr.h"
+
+// Most puzzle servers that requests can be spread across
+#define NET_MAX_SERVERS 4
+
+// The defaults used at boot, everything but the MAC can then be changed from the console or a CONFIG packet
+#ifndef NET_DEFAULT_MAC
+#define NET_DEFAULT_MAC {0x00, 0x11, 0x22, 0x33, 0x00, 0x59} // Put your own MAC address here!
+#endif
+#define NET_DEFAULT_SERVER_IP(ip) IP4_ADDR(ip, 192, 168, 10, 1)
+#define NET_DEFAULT_GATEWAY(ip) IP4_ADDR(ip, 192, 168, 0, 1)
+#define NET_DEFAULT_NETMASK(ip) IP4_ADDR(ip, 255, 255, 255, 0)
+// How often telemetry is sent when the "telemetry" command does not say, it is off until a destination is set
+#define NET_DEFAULT_TELEMETRY_MS 1000
+
+typedef struct {
+    ip_addr_t addr;
+    u16 port;
+} net_endpoint_t;
+
+typedef struct {
+    // The MAC is only read when the interface is brought up at boot
+    u8 mac[6];
+    u8 use_dhcp;
+    // The static settings, these are only used when use_dhcp is 0
+    ip_addr_t ip;
+    ip_addr_t netmask;
+    ip_addr_t gw;
+    // Requests go to each server in turn
+    net_endpoint_t servers[NET_MAX_SERVERS];
+    u32 server_count;
+    u32 next_server;
+    // Where STATS packets go and how often, 0 turns them off
+    net_endpoint_t telemetry;
+    u32 telemetry_ms;
+} net_config_t;
+
+extern net_config_t net_config;
+
+void net_config_init();
+const net_endpoint_t *net_config_next_server();
+int net_config_command(const char *cmd);
+void net_config_print();
+
+#endif
@@ -20,8 +20,18 @@
 
 #define RESET_RX_CNTR_LIMIT	400
 
+/*
+ * The private timer is clocked at half the CPU clock and reloads every 250ms
+ */
+#define TIMER_LOAD_VALUE	(XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 8)
+#define TIMER_COUNTS_PER_US	(XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2 / 1000000)
+#define TIMER_PERIOD_US		250000
+
 static XScuTimer TimerInstance;
 
+/* Number of timer periods since init_timer() */
+static volatile u32 TimerTicks = 0;
+
 #ifndef USE_SOFTETH_ON_ZYNQ
 static int ResetRxCntr = 0;
 extern struct netif *echo_netif;
@@ -30,6 +40,10 @@ extern struct netif *echo_netif;
 volatile int TcpFastTmrFlag = 0;
 volatile int TcpSlowTmrFlag = 0;
 
+/* Set once init_platform() has built the netif list, the timer leaves lwIP alone until then
+ * and while the address settings are being changed */
+static volatile int lwip_ready = 0;
+
 #if LWIP_DHCP==1
 volatile int dhcp_timoutcntr = 200;
 void dhcp_fine_tmr();
@@ -45,6 +59,7 @@ void timer_callback(XScuTimer * TimerInstance) {
     static int dhcp_timer = 0;
 #endif
 	 TcpFastTmrFlag = 1;
+	 TimerTicks++;
 
 	odd = !odd;
 #ifndef USE_SOFTETH_ON_ZYNQ
@@ -57,10 +72,12 @@ void timer_callback(XScuTimer * TimerInstance) {
 #endif
 		TcpSlowTmrFlag = 1;
 #if LWIP_DHCP==1
-		dhcp_fine_tmr();
-		if (dhcp_timer >= 120) {
-			dhcp_coarse_tmr();
-			dhcp_timer = 0;
+		if (lwip_ready) {
+			dhcp_fine_tmr();
+			if (dhcp_timer >= 120) {
+				dhcp_coarse_tmr();
+				dhcp_timer = 0;
+			}
 		}
 #endif
 	}
@@ -74,7 +91,8 @@ void timer_callback(XScuTimer * TimerInstance) {
 	 * milliseconds.
 	 */
 #ifndef USE_SOFTETH_ON_ZYNQ
-	if (ResetRxCntr >= RESET_RX_CNTR_LIMIT) {
+	/* The timer is started before the network interface is added */
+	if (lwip_ready && ResetRxCntr >= RESET_RX_CNTR_LIMIT) {
 		xemacpsif_resetrx_on_no_rxdata(echo_netif);
 		ResetRxCntr = 0;
 	}
@@ -110,7 +128,7 @@ void platform_setup_timer(void)
 	/*
 	 * Set for 250 milli seconds timeout.
 	 */
-	TimerLoadValue = XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 8;
+	TimerLoadValue = TIMER_LOAD_VALUE;
 
 	XScuTimer_LoadTimer(&TimerInstance, TimerLoadValue);
 	return;
@@ -156,6 +174,40 @@ void platform_enable_interrupts() {
 }
 
 
+/*
+ * Starts the timer on its own so that boot can be timed before the network is brought up.
+ * Until init_platform() has finished the interrupt only sets the TCP flags and counts ticks,
+ * the DHCP timers and the Rx reset are held back so they can't run while lwIP is being set up.
+ */
+void init_timer() {
+	platform_setup_timer();
+	platform_setup_interrupts();
+	platform_enable_interrupts();
+}
+
+/*
+ * Microseconds since init_timer(), from the tick count plus how far the counter is through the current period.
+ * The result wraps after about 71 minutes which is plenty for timing boot and individual puzzles.
+ */
+u32 platform_time_us() {
+	u32 ticks, count;
+
+	/* Read again if the tick interrupt fired between reading the two values */
+	do {
+		ticks = TimerTicks;
+		count = XScuTimer_GetCounterValue(&TimerInstance);
+	} while (ticks != TimerTicks);
+
+	return ticks * TIMER_PERIOD_US + (TIMER_LOAD_VALUE - count) / TIMER_COUNTS_PER_US;
+}
+
+/*
+ * Timer periods since init_timer(), each is PLATFORM_TICK_MS long.
+ */
+u32 platform_ticks() {
+	return TimerTicks;
+}
+
 void cleanup_platform() {
 	Xil_ICacheDisable();
 	Xil_DCacheDisable();
@@ -170,8 +222,15 @@ struct netif *echo_netif;
 #if LWIP_DHCP==1
 extern volatile int dhcp_timoutcntr;
 err_t dhcp_start(struct netif *netif);
+/* Set while DHCP is looking after the address */
+static int dhcp_running = 0;
+/* Set once the timeout has been reported, so it is printed once for each time DHCP is started */
+static int dhcp_timed_out = 0;
 #endif
 
+/* Set once the address has been printed, cleared whenever the address is changed */
+static int net_reported = 0;
+
 void lwip_init();
 
 void print_ip(char *msg, ip_addr_t *ip)  {
@@ -185,77 +244,122 @@ void print_ip_settings(ip_addr_t *ip, ip_addr_t *mask, ip_addr_t *gw) {
 	print_ip("Gateway : ", gw);
 }
 
-int init_platform(unsigned char *mac_ethernet_address, ip_addr_t *ipaddr, ip_addr_t *netmask) {
-	ip_addr_t gw;
-	IP4_ADDR(&gw, 192, 168, 0, 1);
+int init_platform(unsigned char *mac_ethernet_address, ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw, int use_dhcp) {
+	ip_addr_t any;
+	any.addr = 0;
 
 	echo_netif = &server_netif;
 
 #if LWIP_DHCP==1
-	ip_addr_t ipaddr_dhcp;
-	ip_addr_t netmask_dhcp;
-	ipaddr = &ipaddr_dhcp;
-	netmask = &netmask_dhcp;
-
-    ipaddr->addr = 0;
-	gw.addr = 0;
-	netmask->addr = 0;
+	/* With DHCP the interface starts with no address */
+	if (use_dhcp) {
+		ipaddr = &any;
+		netmask = &any;
+		gw = &any;
+	}
 #else
-	if(ipaddr == NULL || netmask == NULL) {
-		xil_printf("When DHCP is disabled you must provide an IP address and netmask.\r\n");
-		return -1;
+	if (use_dhcp) {
+		xil_printf("DHCP is not built in, using the static address.\r\n");
+		use_dhcp = 0;
 	}
 #endif
-
-
-	platform_setup_timer();
-	platform_setup_interrupts();
+	if(ipaddr == NULL || netmask == NULL || gw == NULL) {
+		xil_printf("When DHCP is disabled you must provide an IP address, netmask and gateway.\r\n");
+		return -1;
+	}
 
 
 	lwip_init();
 
   	/* Add network interface to the netif_list, and set it as default */
-	if (!xemac_add(echo_netif, ipaddr, netmask, &gw, mac_ethernet_address, PLATFORM_EMAC_BASEADDR)) {
+	if (!xemac_add(echo_netif, ipaddr, netmask, gw, mac_ethernet_address, PLATFORM_EMAC_BASEADDR)) {
 		xil_printf("Error adding N/W interface\r\n");
 		return -1;
 	}
 	netif_set_default(echo_netif);
 
-	/* now enable interrupts */
-	platform_enable_interrupts();
-
 	/* specify that the network if is up */
 	netif_set_up(echo_netif);
 
 #if (LWIP_DHCP==1)
-	/* Create a new DHCP client for this interface.
-	 * Note: you must call dhcp_fine_tmr() and dhcp_coarse_tmr() at
-	 * the predefined regular intervals after starting the client.
+	/*
+	 * Don't wait for the lease here, the rest of the system is brought up while DHCP runs
+	 * and platform_net_ready() reports when an address has been assigned.
 	 */
+	if (use_dhcp)
+		platform_start_dhcp();
+#endif
+	lwip_ready = 1;
+	return 0;
+}
+
+/*
+ * Switches to a static address, stopping DHCP if it was running.
+ */
+void platform_set_static(ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw) {
+	int was_ready = lwip_ready;
+
+	lwip_ready = 0;
+#if LWIP_DHCP==1
+	if (dhcp_running) {
+		dhcp_stop(echo_netif);
+		dhcp_running = 0;
+	}
+#endif
+	netif_set_addr(echo_netif, ipaddr, netmask, gw);
+	net_reported = 0;
+	lwip_ready = was_ready;
+}
+
+#if LWIP_DHCP==1
+/*
+ * Starts (or restarts) getting an address with DHCP.
+ * Note: you must call dhcp_fine_tmr() and dhcp_coarse_tmr() at
+ * the predefined regular intervals after starting the client, the timer does this.
+ */
+void platform_start_dhcp() {
+	ip_addr_t any;
+	int was_ready = lwip_ready;
+	any.addr = 0;
+
+	/* Keep the timer's DHCP calls out while the client is stopped and started again */
+	lwip_ready = 0;
+	if (dhcp_running)
+		dhcp_stop(echo_netif);
+	netif_set_addr(echo_netif, &any, &any, &any);
 	dhcp_start(echo_netif);
 	dhcp_timoutcntr = 200;
+	dhcp_timed_out = 0;
+	dhcp_running = 1;
+	net_reported = 0;
+	lwip_ready = was_ready;
+}
+#endif
 
-	while(((echo_netif->ip_addr.addr) == 0) && (dhcp_timoutcntr > 0))
-		xemacif_input(echo_netif);
+/*
+ * Returns 1 once the interface has an address and packets can be sent.
+ * With DHCP this also prints the settings the first time the lease is seen.
+ */
+int platform_net_ready() {
+	if (net_reported)
+		return 1;
 
-	if (dhcp_timoutcntr <= 0) {
-		if ((echo_netif->ip_addr.addr) == 0) {
+	if ((echo_netif->ip_addr.addr) == 0) {
+#if LWIP_DHCP==1
+		if (dhcp_running && dhcp_timoutcntr <= 0 && !dhcp_timed_out) {
 			xil_printf("DHCP Timeout\r\n");
-			return -1;
+			dhcp_timed_out = 1;
 		}
-	}
-
-	ipaddr->addr = echo_netif->ip_addr.addr;
-	gw.addr = echo_netif->gw.addr;
-	netmask->addr = echo_netif->netmask.addr;
 #endif
+		return 0;
+	}
 
-	print_ip_settings(ipaddr, netmask, &gw);
-
-	return 0;
+	print_ip_settings(&echo_netif->ip_addr, &echo_netif->netmask, &echo_netif->gw);
+	net_reported = 1;
+	return 1;
 }
 
 void handle_ethernet() {
-	/* receive and process packets */
-	xemacif_input(echo_netif);
+	/* receive and process every packet the receive interrupt has queued */
+	while (xemacif_input(echo_netif) > 0);
 }
@@ -9,7 +9,16 @@
 #include <lwip/ip_addr.h>
 #include <lwip/udp.h>
 
-int init_platform(unsigned char *mac_ethernet_address, ip_addr_t *ipaddr, ip_addr_t *netmask);
+// How often the timer interrupt fires, periodic work in the main loop is scheduled in these ticks
+#define PLATFORM_TICK_MS 250
+
+void init_timer();
+u32 platform_time_us();
+u32 platform_ticks();
+int init_platform(unsigned char *mac_ethernet_address, ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw, int use_dhcp);
+void platform_set_static(ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw);
+void platform_start_dhcp();
+int platform_net_ready();
 void handle_ethernet();
 
 #endif
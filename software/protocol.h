@@ -0,0 +1,154 @@
+#ifndef __PROTOCOL_H_
+#define __PROTOCOL_H_
+
+#include "xil_types.h"
+
+// Packets exchanged with the puzzle server, shared between the firmware and the host tools
+// All multi byte fields are sent most significant byte first and every packet starts with a header byte
+
+// Port the server listens on and the board listens on for replies
+#define PROTO_PORT 51050
+
+// Largest payload put in a single datagram, this fits in an ethernet frame with the IP and UDP headers
+#define PROTO_MAX_PAYLOAD 1400
+
+// Single puzzle request and response
+// Request: proto_req_t
+// Response: header, size, seed[4] then size * size tiles of 4 bytes
+#define REQ_HEADER 0x01
+#define RESP_HEADER 0x02
+#define RESP_HEADER_LEN 6
+
+// Batch request for count consecutive seeds starting at seed
+// The server packs as many whole puzzles as fit into each response datagram, so a batch may take several
+// Request: proto_batch_req_t, id is echoed in every reply so they can be matched to the request
+// Response: header, size, count, seed[4] of the first puzzle, id[2] then count puzzles of size * size tiles
+// A request that is not fully answered in time is sent again with the same id for the seeds still missing
+#define BATCH_REQ_HEADER 0x03
+#define BATCH_RESP_HEADER 0x04
+#define BATCH_RESP_HEADER_LEN 9
+// Most puzzles that can be asked for in one batch request
+#define BATCH_MAX_COUNT 255
+
+// A part of a puzzle that is too big for one datagram, sent in reply to either kind of request
+// Header, size, seed[4], first[2] tile index, count[2] tiles, id[2] then the tiles
+// The id is the batch request's, or 0 in reply to a single request which is matched on its size and seed
+// The puzzle is complete once all size * size tiles have been recieved, fragments can arrive in any order
+#define FRAG_HEADER 0x05
+#define FRAG_HEADER_LEN 12
+
+// A unique solution found by the board, sent to the host that the puzzle came from
+// Header, size, seed[4], index of the solution counting from 1, time[4] in us since solving started then the tiles
+#define RESULT_HEADER 0x06
+#define RESULT_HEADER_LEN 11
+
+// Sent once a puzzle has finished, after all of its results
+// Header, size, seed[4], solutions[2], flags, time[4] in us the puzzle took to solve
+#define SUMMARY_HEADER 0x07
+#define SUMMARY_LEN 13
+// Set in the flags when the search was stopped early, so there may be more solutions
+#define SUMMARY_ABORTED 0x01
+// Set when the solution buffer filled up, only the first solutions were sent
+#define SUMMARY_BUF_FULL 0x02
+// Set when the puzzle's edge colours can't pair up so it was not searched at all, there are no solutions
+// Firmware built for PACKED_TILES cores also sets it for colours of 32 or more, which those cores can't hold
+#define SUMMARY_INFEASIBLE 0x08
+// Set when the puzzle was solved in a batch with others, the time is then for the whole batch not just this puzzle
+// 0x04 is left out as JOB_DONE uses it for JOB_REJECTED
+#define SUMMARY_BATCH 0x10
+// No flag is set when a new solution is lost because its 32 bit hash, taken over its turns, matches one already
+// found, the cores skip it as a duplicate. With the 20 solutions kept that is about 1 in 200 million per solution
+
+// Cluster mode, a coordinator splits one puzzle into jobs over ranges of the tile placed first and hands them out
+// The coordinator sends HELLO to every board it knows about and boards answer with ADVERTISE
+// Boards that stop answering have their jobs given to another board
+// HELLO: header
+// ADVERTISE: header, free, cores, queued where free is how many more jobs the board can take
+#define HELLO_HEADER 0x08
+#define HELLO_LEN 1
+#define ADVERTISE_HEADER 0x09
+#define ADVERTISE_LEN 4
+
+// JOB: header, id[4], size, start, end then the tiles, the board searches with tiles start to end - 1 placed first
+// JOB_RESULT: header, id[4], size, index, time[4] then the tiles of a solution
+// JOB_DONE: header, id[4], solutions[2], flags, time[4] using the SUMMARY_* flags and JOB_REJECTED
+#define JOB_HEADER 0x0A
+#define JOB_HEADER_LEN 8
+#define JOB_RESULT_HEADER 0x0B
+#define JOB_RESULT_HEADER_LEN 11
+#define JOB_DONE_HEADER 0x0C
+#define JOB_DONE_LEN 12
+// Set when the board had no room for the job so never ran it
+#define JOB_REJECTED 0x04
+
+// Changes the network settings of a board, the command is text in the same form as the console's ':' commands
+// CONFIG: header then the command, for example "server 192.168.10.1 192.168.10.2:51051"
+// CONFIG_ACK: header, status
+#define CONFIG_HEADER 0x0D
+#define CONFIG_MAX_LEN 128
+#define CONFIG_ACK_HEADER 0x0E
+#define CONFIG_ACK_LEN 2
+#define CONFIG_OK 0
+#define CONFIG_BAD 1
+
+// Telemetry, sent by a board every few seconds to the address set with the "telemetry" command
+// STATS: header, cores, queued, state, uptime[4], puzzles[4], solutions[4], rx[4], tx[4], dropped[4]
+//        then busy[4], runs[4] for each core
+// Everything counts up from boot so a lost packet loses nothing, busy is in ms and includes a search still running
+// A core whose busy time keeps rising without its runs going up is stuck on one search
+#define STATS_HEADER 0x0F
+#define STATS_HEADER_LEN 28
+#define STATS_CORE_LEN 8
+
+// Every tile is sent as its 4 edge colours, top, right, bottom then left
+#define PROTO_TILE_LEN 4
+
+// Reads and writes of big endian fields
+#define PROTO_GET_U16(p) ((u16)(((p)[0] << 8) | (p)[1]))
+#define PROTO_GET_U32(p) ((u32)(((p)[0] << 24) | ((p)[1] << 16) | ((p)[2] << 8) | (p)[3]))
+#define PROTO_PUT_U16(p, v) do { (p)[0] = (v) >> 8; (p)[1] = (v); } while (0)
+#define PROTO_PUT_U32(p, v) do { (p)[0] = (v) >> 24; (p)[1] = (v) >> 16; (p)[2] = (v) >> 8; (p)[3] = (v); } while (0)
+
+// Bytes taken by the tiles of one puzzle
+#define PROTO_PUZZLE_LEN(size) ((size) * (size) * PROTO_TILE_LEN)
+
+// seed is 4 bytes but is represented as a byte array so that the alignment of the struct is 1 byte
+typedef struct {
+    u8 req_header;
+    u8 size;
+    u8 seed[4];
+} proto_req_t;
+
+typedef struct {
+    u8 req_header;
+    u8 size;
+    u8 seed[4];
+    u8 count;
+    u8 id[2];
+} proto_batch_req_t;
+
+typedef struct {
+    u8 header;
+    u8 size;
+    u8 seed[4];
+    u8 solutions[2];
+    u8 flags;
+    u8 time[4];
+} proto_summary_t;
+
+typedef struct {
+    u8 header;
+    u8 free;
+    u8 cores;
+    u8 queued;
+} proto_advertise_t;
+
+typedef struct {
+    u8 header;
+    u8 id[4];
+    u8 solutions[2];
+    u8 flags;
+    u8 time[4];
+} proto_job_done_t;
+
+#endif
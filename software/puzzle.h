@@ -0,0 +1,94 @@
+#ifndef __PUZZLE_H_
+#define __PUZZLE_H_
+
+#include "xil_types.h"
+
+// Maximum size of a puzzle
+#define MAX_SIZE 10
+
+// Makes a tile with the given colours
+#define MAKE_TILE(c1, c2, c3, c4) ((c1 << 24) | (c2 <<16) | (c3 << 8) | (c4))
+
+// Struct for the tiles
+// The field order matches the byte order the hardware solvers expect
+typedef struct {
+    u8 top;
+    u8 bottom;
+    u8 left;
+    u8 right;
+} tile_t;
+
+// Turns a tile a quarter turn clockwise
+static inline tile_t tile_rotate(tile_t t)
+{
+    tile_t r;
+    r.top = t.left;
+    r.left = t.bottom;
+    r.bottom = t.right;
+    r.right = t.top;
+    return r;
+}
+
+// The Bloom filter of solutions already found that the solver cores check before writing one back
+// This must match hardware/toplevel.h, each solution sets the 3 bits picked by 10 bit slices of its hash
+// The bits are followed by the number of solutions and their hashes, which the cores check on a hit
+#define SOLUTION_FILTER_BITS 1024
+#define SOLUTION_FILTER_COUNT (SOLUTION_FILTER_BITS / 32)
+#define SOLUTION_FILTER_HASHES (SOLUTION_FILTER_COUNT + 1)
+#define SOLUTION_FILTER_MAX_HASHES 20
+#define SOLUTION_FILTER_WORDS (SOLUTION_FILTER_HASHES + SOLUTION_FILTER_MAX_HASHES)
+
+// Hash of a tile at a position, the solver cores work this out the same way
+static inline u32 solution_cell_hash(u32 pos, tile_t t)
+{
+    u32 h = (t.top | (t.bottom << 8) | (t.left << 16) | ((u32)t.right << 24)) ^ (pos * 0x9E3779B1);
+    h *= 0x85EBCA6B;
+    return h ^ (h >> 13);
+}
+
+// Hash of a solution that is the same whichever way round the solution is turned
+static inline u32 solution_hash(const tile_t *grid, u8 size)
+{
+    u32 h[4] = {0, 0, 0, 0};
+    for (u32 y = 0; y < size; y++)
+    {
+        for (u32 x = 0; x < size; x++)
+        {
+            tile_t t = grid[y * size + x];
+            h[0] += solution_cell_hash(y * size + x, t);
+            t = tile_rotate(t);
+            h[1] += solution_cell_hash(x * size + size - 1 - y, t);
+            t = tile_rotate(t);
+            h[2] += solution_cell_hash((size - 1 - y) * size + size - 1 - x, t);
+            t = tile_rotate(t);
+            h[3] += solution_cell_hash((size - 1 - x) * size + y, t);
+        }
+    }
+    u32 hash = h[0];
+    for (int r = 1; r < 4; r++)
+        if (h[r] < hash)
+            hash = h[r];
+    return hash;
+}
+
+// Struct to store a recieved puzzle
+typedef struct {
+    u8 size;
+    tile_t tiles[MAX_SIZE * MAX_SIZE];
+} puzzle_t;
+
+// A puzzle in a batch given to a solver core, this must match the BATCH_ layout in hardware/toplevel.h
+// The core searches the whole puzzle and writes back up to BATCH_MAX_SOLUTIONS solutions, turned copies only once
+// It is aligned to HAL_CACHE_LINE, which pads it to the whole lines that BATCH_DESC_WORDS is rounded up to
+#define BATCH_MAX_SOLUTIONS 20
+#define BATCH_FULL 0x01
+#define BATCH_ABORTED 0x02
+typedef struct {
+    u32 size;
+    u32 solutions;      // Written by the core
+    u32 flags;          // BATCH_FULL or BATCH_ABORTED, written by the core
+    tile_t tiles[MAX_SIZE * MAX_SIZE];
+    tile_t solution[BATCH_MAX_SOLUTIONS][MAX_SIZE * MAX_SIZE];
+} __attribute__((aligned(32))) batch_desc_t;
+
+#endif
@@ -0,0 +1,376 @@
+#include <stdio.h>
+#include <string.h>
+#include "render.h"
+
+// Generates the pixel values for the colours
+#define RED     MAKE_PIXEL(0xFF, 0x00, 0x00)
+#define GREEN   MAKE_PIXEL(0x00, 0xFF, 0x00)
+#define BLUE    MAKE_PIXEL(0x00, 0x00, 0xFF)
+#define YELLOW  MAKE_PIXEL(0xFF, 0xFF, 0x00)
+#define MAGENTA MAKE_PIXEL(0xFF, 0x00, 0xFF)
+#define CYAN    MAKE_PIXEL(0x00, 0xFF, 0xFF)
+#define WHITE   MAKE_PIXEL(0xFF, 0xFF, 0xFF)
+#define PURPLE  MAKE_PIXEL(0x63, 0x00, 0x99)
+#define ORANGE  MAKE_PIXEL(0xFF, 0x94, 0x00)
+#define LIME    MAKE_PIXEL(0x53, 0x56, 0x1B)
+// Background colour behind the tiles
+#define BACKGROUND MAKE_PIXEL(0x44, 0x44, 0x44)
+// Side panel colours
+#define PANEL_BACKGROUND MAKE_PIXEL(0x22, 0x22, 0x22)
+#define PANEL_TEXT MAKE_PIXEL(0xDD, 0xDD, 0xDD)
+
+// Glyphs are 5 pixels wide and 7 high, each byte is a row with the left most pixel in bit 4
+#define GLYPH_WIDTH 5
+#define GLYPH_HEIGHT 7
+// Number of characters the panel is scaled to fit across its width
+#define PANEL_COLUMNS 14
+
+static const u8 font_digits[10][GLYPH_HEIGHT] = {
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E},
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E},
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F},
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E},
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02},
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E},
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E},
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08},
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E},
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}
+};
+
+static const u8 font_letters[26][GLYPH_HEIGHT] = {
+    {0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11},
+    {0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E},
+    {0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E},
+    {0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C},
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F},
+    {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10},
+    {0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F},
+    {0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11},
+    {0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E},
+    {0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C},
+    {0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11},
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F},
+    {0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11},
+    {0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11},
+    {0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},
+    {0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10},
+    {0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D},
+    {0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11},
+    {0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E},
+    {0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04},
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E},
+    {0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04},
+    {0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A},
+    {0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11},
+    {0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04},
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}
+};
+
+static const u8 font_slash[GLYPH_HEIGHT] = {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00};
+static const u8 font_colon[GLYPH_HEIGHT] = {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00};
+static const u8 font_dash[GLYPH_HEIGHT] = {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00};
+static const u8 font_dot[GLYPH_HEIGHT] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C};
+
+static const u8 *font_glyph(char c)
+{
+    // Lower case is drawn as upper case, anything we have no glyph for is drawn as a space
+    if (c >= '0' && c <= '9')
+        return font_digits[c - '0'];
+    if (c >= 'A' && c <= 'Z')
+        return font_letters[c - 'A'];
+    if (c >= 'a' && c <= 'z')
+        return font_letters[c - 'a'];
+    switch (c)
+    {
+        case '/':
+            return font_slash;
+        case ':':
+            return font_colon;
+        case '-':
+            return font_dash;
+        case '.':
+            return font_dot;
+        default:
+            return NULL;
+    }
+}
+
+// The palette used to draw the tiles, palette_init() must be called before anything is drawn
+palette_t palette;
+
+static u32 hsv_pixel(u32 hue, u32 sat, u32 val)
+{
+	// Integer HSV to RGB, hue is in degrees and sat and val are 0-255
+	u32 region = hue / 60;
+	u32 rem = ((hue % 60) * 255) / 60;
+	u32 p = (val * (255 - sat)) / 255;
+	u32 q = (val * (255 - ((sat * rem) / 255))) / 255;
+	u32 t = (val * (255 - ((sat * (255 - rem)) / 255))) / 255;
+
+	switch (region)
+	{
+		case 0:
+			return MAKE_PIXEL(val, t, p);
+		case 1:
+			return MAKE_PIXEL(q, val, p);
+		case 2:
+			return MAKE_PIXEL(p, val, t);
+		case 3:
+			return MAKE_PIXEL(p, q, val);
+		case 4:
+			return MAKE_PIXEL(t, p, val);
+		default:
+			return MAKE_PIXEL(val, p, q);
+	}
+}
+
+void palette_init()
+{
+	// The first ten codes keep the colours that have always been used for them
+	static const u32 fixed[] = {RED, GREEN, BLUE, YELLOW, MAGENTA, CYAN, WHITE, PURPLE, ORANGE, LIME};
+	u32 code;
+
+	for (code = 0; code < sizeof(fixed) / sizeof(fixed[0]); code++)
+		palette_set(code, fixed[code], 0, PATTERN_SOLID);
+
+	// The rest of the solid colours step around the hue circle by the golden angle so consecutive codes are never close,
+	// and cycle through brightness and saturation levels so codes that do land on similar hues can still be told apart
+	for (; code < PALETTE_SOLID; code++)
+	{
+		u32 hue = (code * 1375 / 10) % 360;
+		u32 val = 255 - (code % 3) * 60;
+		u32 sat = (code % 2) ? 255 : 170;
+		palette_set(code, hsv_pixel(hue, sat, val), 0, PATTERN_SOLID);
+	}
+
+	// Above that each block of PALETTE_SOLID codes reuses the solid colours with a different pattern over the top
+	for (; code < PALETTE_SIZE; code++)
+	{
+		u32 block = (code / PALETTE_SOLID) - 1;
+		u8 pattern = PATTERN_STRIPES + (block % 3);
+		u32 alt = (block / 3) % 2 ? WHITE : MAKE_PIXEL(0x00, 0x00, 0x00);
+		palette_set(code, palette.pixel[code % PALETTE_SOLID], alt, pattern);
+	}
+}
+
+void palette_set(u8 color, u32 pixel, u32 alt, u8 pattern)
+{
+	palette.pixel[color] = pixel;
+	palette.alt[color] = alt;
+	palette.pattern[color] = pattern;
+}
+
+u32 get_color(u8 color)
+{
+	// The palette is indexed directly by the colour information from the server
+	return palette.pixel[color];
+}
+
+static void fill_span(u32 *line, u32 x, u32 y, u32 len, u8 color)
+{
+	u32 pixel = palette.pixel[color];
+
+	// Solid colours are the common case so keep that loop as simple as possible
+	if (palette.pattern[color] == PATTERN_SOLID)
+	{
+		for (u32 i = 0; i < len; i++)
+			line[x + i] = pixel;
+		return;
+	}
+
+	// Patterns are worked out from the screen position so they line up across the edges of a tile
+	u32 alt = palette.alt[color];
+	for (u32 i = x; i < x + len; i++)
+	{
+		u32 use_alt;
+		switch (palette.pattern[color])
+		{
+			case PATTERN_STRIPES:
+				use_alt = ((i + y) >> 2) & 1;
+				break;
+			case PATTERN_CHECKER:
+				use_alt = ((i >> 3) ^ (y >> 3)) & 1;
+				break;
+			default:
+				use_alt = ((i & 3) == 0) && ((y & 3) == 0);
+				break;
+		}
+		line[i] = use_alt ? alt : pixel;
+	}
+}
+
+void layout_compute(layout_t *l, u32 width, u32 height, u8 size)
+{
+	// The grid is square so it is limited by the shorter side of the screen
+	u32 side = height < width ? height : width;
+
+	l->size = size;
+	l->pitch = (side - LAYOUT_GAP) / size;
+	l->tile_size = l->pitch - LAYOUT_GAP;
+
+	// Keep the grid against the left edge and centre it vertically
+	l->origin_x = LAYOUT_GAP;
+	l->origin_y = LAYOUT_GAP + (side - LAYOUT_GAP - (l->pitch * size)) / 2;
+
+	// Whatever is to the right of the grid becomes the side panel
+	l->panel_x = l->origin_x + (l->pitch * size);
+	l->panel_y = LAYOUT_GAP;
+	l->panel_h = height - (2 * LAYOUT_GAP);
+	if (width > l->panel_x + LAYOUT_GAP + LAYOUT_MIN_PANEL)
+		l->panel_w = width - l->panel_x - LAYOUT_GAP;
+	else
+		l->panel_w = 0;
+}
+
+void render_gradient(surface_t *s)
+{
+	int x, y;
+	u32 *frame = s->frame;
+	u32 red, green, blue;
+
+	// Fill the screen with a nice gradient pattern
+	for (y = 0; y < s->height; y++) {
+		for (x = 0; x < s->width; x++) {
+			green = (x*0xFF) / s->width;
+			blue = 0xFF - ((x*0xFF) / s->width);
+			red = (y*0xFF) / s->height;
+			frame[y*s->stride + x] = MAKE_PIXEL(red, green, blue);
+		}
+	}
+}
+
+void render_splash(surface_t *s, const char *msg)
+{
+	u32 *frame = s->frame;
+	u32 scale = s->width / 320;
+
+	// Work out one row of a horizontal gradient, then copy it down the screen
+	// This is one division per column rather than three per pixel like the full test pattern
+	for (u32 x = 0; x < s->width; x++)
+	{
+		u32 green = (x * 0x80) / s->width;
+		frame[x] = MAKE_PIXEL(0x00, green, 0x80 - green);
+	}
+	for (u32 y = 1; y < s->height; y++)
+		memcpy(frame + y * s->stride, frame, s->width * sizeof(u32));
+
+	if (scale < 1)
+		scale = 1;
+	render_text(s, 4 * scale, 4 * scale, scale, MAKE_PIXEL(0xFF, 0xFF, 0xFF), msg);
+}
+
+void render_fill(surface_t *s, u32 x, u32 y, u32 w, u32 h, u32 pixel)
+{
+	// Fill a rectangle, anything off the edge of the surface is clipped
+	if (x >= s->width || y >= s->height)
+		return;
+	if (w > s->width - x)
+		w = s->width - x;
+	if (h > s->height - y)
+		h = s->height - y;
+
+	for (u32 row = y; row < y + h; row++)
+	{
+		u32 *line = s->frame + row * s->stride + x;
+		for (u32 col = 0; col < w; col++)
+			line[col] = pixel;
+	}
+}
+
+void render_text(surface_t *s, u32 x, u32 y, u32 scale, u32 pixel, const char *str)
+{
+	// Each glyph pixel becomes a scale x scale block, with a one pixel gap between characters
+	for (; *str; str++, x += (GLYPH_WIDTH + 1) * scale)
+	{
+		const u8 *glyph = font_glyph(*str);
+		if (!glyph)
+			continue;
+
+		for (u32 row = 0; row < GLYPH_HEIGHT; row++)
+		{
+			for (u32 col = 0; col < GLYPH_WIDTH; col++)
+			{
+				if (glyph[row] & (0x10 >> col))
+					render_fill(s, x + col * scale, y + row * scale, scale, scale, pixel);
+			}
+		}
+	}
+}
+
+void render_tile(surface_t *s, const layout_t *l, tile_t *tile, u32 idx)
+{
+	u32 tile_size = l->tile_size;
+	u32 half = tile_size / 2;
+
+	u32 x = l->origin_x + (idx % l->size) * l->pitch;
+	u32 y = l->origin_y + (idx / l->size) * l->pitch;
+
+	// The tile is drawn a row at a time as up to three spans so that memory is written in order
+	// On each row the left and right triangles are as wide as the distance to the nearest horizontal edge
+	// and the top or bottom triangle fills what is left in the middle
+	for (u32 row = 0; row < tile_size; row++)
+	{
+		u32 *line = s->frame + (y + row) * s->stride;
+		u32 edge = row < tile_size - row - 1 ? row : tile_size - row - 1;
+		u32 side = edge + 1 < half ? edge + 1 : half;
+		u8 middle = row < half ? tile->top : tile->bottom;
+
+		fill_span(line, x, y + row, side, tile->left);
+		fill_span(line, x + side, y + row, tile_size - (2 * side), middle);
+		fill_span(line, x + tile_size - side, y + row, side, tile->right);
+	}
+}
+
+void render_puzzle(surface_t *s, const layout_t *l, tile_t *puzzle)
+{
+	// Fill the screen with a grey background
+	render_fill(s, 0, 0, s->width, s->height, BACKGROUND);
+
+	// Display all of the tiles
+	for (int i = 0; i < l->size * l->size; i++)
+	{
+		render_tile(s, l, puzzle + i, i);
+	}
+}
+
+void render_panel(surface_t *s, const layout_t *l, const panel_info_t *info)
+{
+	char line[32];
+
+	if (l->panel_w == 0)
+		return;
+
+	// Scale the text so a full line fits across the panel
+	u32 scale = l->panel_w / (PANEL_COLUMNS * (GLYPH_WIDTH + 1));
+	if (scale < 1)
+		scale = 1;
+	u32 line_height = (GLYPH_HEIGHT + 3) * scale;
+	u32 x = l->panel_x + 2 * scale;
+	u32 y = l->panel_y + 2 * scale;
+
+	// Only the panel is redrawn so this can be called on its own when the stats change
+	render_fill(s, l->panel_x, l->panel_y, l->panel_w, l->panel_h, PANEL_BACKGROUND);
+
+	snprintf(line, sizeof(line), "SIZE %u", info->size);
+	render_text(s, x, y, scale, PANEL_TEXT, line);
+	y += line_height;
+
+	snprintf(line, sizeof(line), "SEED %u", (unsigned int)info->seed);
+	render_text(s, x, y, scale, PANEL_TEXT, line);
+	y += line_height * 2;
+
+	if (info->sol_idx < 0)
+		snprintf(line, sizeof(line), "PUZZLE");
+	else
+		snprintf(line, sizeof(line), "SOLUTION %d/%d", (int)info->sol_idx + 1, (int)info->sol_count);
+	render_text(s, x, y, scale, PANEL_TEXT, line);
+	y += line_height;
+
+	snprintf(line, sizeof(line), "FOUND %d", (int)info->sol_count);
+	render_text(s, x, y, scale, PANEL_TEXT, line);
+	y += line_height;
+
+	snprintf(line, sizeof(line), "CORES %u/%u", (unsigned int)info->solvers_running, (unsigned int)info->solver_count);
+	render_text(s, x, y, scale, PANEL_TEXT, line);
+}
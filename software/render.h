@@ -0,0 +1,80 @@
+#ifndef __RENDER_H_
+#define __RENDER_H_
+
+#include "display.h"
+#include "puzzle.h"
+
+#define RED_CODE 0x00
+#define GREEN_CODE 0x01
+#define BLUE_CODE 0x02
+#define YELLOW_CODE 0x03
+#define MAGENTA_CODE 0x04
+#define CYAN_CODE 0x05
+#define WHITE_CODE 0x06
+#define PURPLE_CODE 0x07
+#define ORANGE_CODE 0x08
+#define LIME_CODE 0x09
+
+// Number of entries in the palette, one for every value of the tile colour byte
+#define PALETTE_SIZE 256
+// Codes below this get a distinct solid colour, the codes above reuse them with a fill pattern
+#define PALETTE_SOLID 32
+
+// Fill patterns, the second colour of the pattern comes from palette_t.alt
+#define PATTERN_SOLID 0
+#define PATTERN_STRIPES 1
+#define PATTERN_CHECKER 2
+#define PATTERN_DOTS 3
+
+// Maps the colour byte of a tile edge straight to what is drawn
+// Pixels are stored already shifted into the PIXEL_BIT_* layout
+typedef struct {
+    u32 pixel[PALETTE_SIZE];
+    u32 alt[PALETTE_SIZE];
+    u8 pattern[PALETTE_SIZE];
+} palette_t;
+
+// Gap left between tiles and around the edge of the grid
+#define LAYOUT_GAP 5
+// The side panel is only drawn if at least this much width is left over
+#define LAYOUT_MIN_PANEL 120
+
+// Where everything goes on the screen for a given mode and puzzle size
+// The grid is square so its size is limited by the height, any spare width is given to the side panel
+typedef struct {
+    u8 size;
+    u32 pitch;      // Distance between the origins of neighbouring tiles
+    u32 tile_size;  // Drawn width and height of a tile, pitch less the gap
+    u32 origin_x;   // Top left of the first tile
+    u32 origin_y;
+    u32 panel_x;    // Side panel rectangle, panel_w is 0 if there is no room for it
+    u32 panel_y;
+    u32 panel_w;
+    u32 panel_h;
+} layout_t;
+
+// Information shown in the side panel
+typedef struct {
+    u8 size;
+    u32 seed;
+    s32 sol_idx;    // Solution being shown, -1 for the puzzle as recieved
+    s32 sol_count;
+    u32 solvers_running;
+    u32 solver_count;
+} panel_info_t;
+
+extern palette_t palette;
+
+void palette_init();
+void palette_set(u8 color, u32 pixel, u32 alt, u8 pattern);
+u32 get_color(u8 color);
+void layout_compute(layout_t *l, u32 width, u32 height, u8 size);
+void render_gradient(surface_t *s);
+void render_splash(surface_t *s, const char *msg);
+void render_fill(surface_t *s, u32 x, u32 y, u32 w, u32 h, u32 pixel);
+void render_text(surface_t *s, u32 x, u32 y, u32 scale, u32 pixel, const char *str);
+void render_tile(surface_t *s, const layout_t *l, tile_t *tile, u32 idx);
+void render_puzzle(surface_t *s, const layout_t *l, tile_t *puzzle);
+void render_panel(surface_t *s, const layout_t *l, const panel_info_t *info);
+
+#endif
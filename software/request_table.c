@@ -0,0 +1,103 @@
+#include "request_table.h"
+
+void request_table_clear(request_table_t *t)
+{
+    // The id carries on counting so replies to requests from before the clear never match
+    for (u32 i = 0; i < REQUEST_TABLE_SIZE; i++)
+        t->requests[i].used = 0;
+}
+
+u32 request_table_free(request_table_t *t)
+{
+    u32 free = 0;
+    for (u32 i = 0; i < REQUEST_TABLE_SIZE; i++)
+        free += !t->requests[i].used;
+    return free;
+}
+
+request_t *request_add(request_table_t *t, u8 size, u32 seed, u32 count, u32 now)
+{
+    // Returns the new request so its id can be sent, or NULL if the table is full
+    if (count == 0 || count > REQUEST_MAX_COUNT)
+        return NULL;
+
+    for (u32 i = 0; i < REQUEST_TABLE_SIZE; i++)
+    {
+        request_t *r = &t->requests[i];
+        if (r->used)
+            continue;
+
+        // 0 is left for replies to single requests, which have no id
+        if (++t->next_id == 0)
+            t->next_id = 1;
+        r->id = t->next_id;
+        r->size = size;
+        r->count = count;
+        r->seed = seed;
+        r->have = 0;
+        r->sent_us = now;
+        r->timeout_us = REQUEST_TIMEOUT_US;
+        r->tries = 1;
+        r->used = 1;
+        return r;
+    }
+    return NULL;
+}
+
+request_t *request_match(request_table_t *t, u8 size, u32 seed, u16 id)
+{
+    // Finds the request a reply for one puzzle answers, NULL if nothing is waiting for it
+    // A reply with id 0 is matched on the size and seed alone
+    for (u32 i = 0; i < REQUEST_TABLE_SIZE; i++)
+    {
+        request_t *r = &t->requests[i];
+        u32 bit = seed - r->seed;
+        if (r->used && r->size == size && (id == 0 || id == r->id) &&
+                bit < r->count && !(r->have & (1u << bit)))
+            return r;
+    }
+    return NULL;
+}
+
+void request_received(request_t *r, u32 seed)
+{
+    // The request is finished with once every puzzle has arrived
+    r->have |= 1u << (seed - r->seed);
+    if (r->have == (r->count == 32 ? 0xFFFFFFFF : (1u << r->count) - 1))
+        r->used = 0;
+}
+
+request_t *request_due(request_table_t *t, u32 now)
+{
+    // Returns a request that has waited too long for its replies, it should be sent again or given up on
+    for (u32 i = 0; i < REQUEST_TABLE_SIZE; i++)
+    {
+        request_t *r = &t->requests[i];
+        if (r->used && now - r->sent_us >= r->timeout_us)
+            return r;
+    }
+    return NULL;
+}
+
+void request_sent(request_t *r, u32 now)
+{
+    // Back off so a server that is struggling is not flooded with retries
+    r->sent_us = now;
+    r->tries++;
+    r->timeout_us *= 2;
+    if (r->timeout_us > REQUEST_MAX_TIMEOUT_US)
+        r->timeout_us = REQUEST_MAX_TIMEOUT_US;
+}
+
+u32 request_missing(request_t *r)
+{
+    u32 missing = 0;
+    for (u32 i = 0; i < r->count; i++)
+        missing += !(r->have & (1u << i));
+    return missing;
+}
+
+void request_free(request_t *r)
+{
+    r->used = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef __REQUEST_TABLE_H_
+#define __REQUEST_TABLE_H_
+
+#include "xil_types.h"
+
+// Most requests that can be waiting for replies at once
+#define REQUEST_TABLE_SIZE 8
+// Most puzzles one request can ask for, which of them have arrived is kept as a bit each
+#define REQUEST_MAX_COUNT 32
+// How long to wait for the first reply before asking again, this doubles on every retry up to the max
+#define REQUEST_TIMEOUT_US 200000
+#define REQUEST_MAX_TIMEOUT_US 2000000
+// Times a request is sent before the puzzles still missing are given up on
+#define REQUEST_MAX_TRIES 5
+
+// A request for count puzzles with consecutive seeds that has not been fully answered
+// Replies echo the id so a late reply to an earlier request for the same seeds is not taken for this one
+typedef struct {
+    u16 id;
+    u8 size;
+    u8 count;
+    u32 seed;
+    u32 have;
+    u32 sent_us;
+    u32 timeout_us;
+    u8 tries;
+    u8 used;
+} request_t;
+
+typedef struct {
+    request_t requests[REQUEST_TABLE_SIZE];
+    u16 next_id;
+} request_table_t;
+
+void request_table_clear(request_table_t *t);
+u32 request_table_free(request_table_t *t);
+request_t *request_add(request_table_t *t, u8 size, u32 seed, u32 count, u32 now);
+request_t *request_match(request_table_t *t, u8 size, u32 seed, u16 id);
+void request_received(request_t *r, u32 seed);
+request_t *request_due(request_table_t *t, u32 now);
+void request_sent(request_t *r, u32 now);
+u32 request_missing(request_t *r);
+void request_free(request_t *r);
+
+#endif
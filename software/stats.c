@@ -0,0 +1,84 @@
+#include <string.h>
+#include "platform.h"
+#include "protocol.h"
+#include "net.h"
+#include "net_config.h"
+#include "stats.h"
+
+stats_t stats;
+
+static u8 stats_buf[STATS_HEADER_LEN + STATS_MAX_CORES * STATS_CORE_LEN];
+static u32 last_sent_tick;
+
+void stats_init(u32 cores)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.cores = cores > STATS_MAX_CORES ? STATS_MAX_CORES : cores;
+    last_sent_tick = platform_ticks();
+}
+
+// Adds the time a core has been running since it was started or last counted
+static void add_busy(u32 core, u32 now)
+{
+    stats.busy_us[core] += now - stats.started_us[core];
+    stats.busy_ms[core] += stats.busy_us[core] / 1000;
+    stats.busy_us[core] %= 1000;
+    stats.started_us[core] = now;
+}
+
+void stats_core_start(u32 core)
+{
+    if (core >= stats.cores)
+        return;
+    stats.started_us[core] = platform_time_us();
+    stats.running[core] = 1;
+    stats.runs[core]++;
+}
+
+void stats_core_stop(u32 core)
+{
+    if (core >= stats.cores || !stats.running[core])
+        return;
+    add_busy(core, platform_time_us());
+    stats.running[core] = 0;
+}
+
+void stats_poll(u32 queued, u8 solving)
+{
+    u32 ticks = platform_ticks();
+    u32 period = (net_config.telemetry_ms + PLATFORM_TICK_MS - 1) / PLATFORM_TICK_MS;
+    if (period == 0)
+        period = 1;
+    if (ticks - last_sent_tick < period)
+        return;
+    last_sent_tick = ticks;
+
+    // Count the time of searches still running, this also stops the microsecond timer wrapping on long searches
+    u32 now = platform_time_us();
+    for (u32 i = 0; i < stats.cores; i++)
+        if (stats.running[i])
+            add_busy(i, now);
+
+    if (!net_config.telemetry_ms)
+        return;
+
+    u8 *b = stats_buf;
+    b[0] = STATS_HEADER;
+    b[1] = stats.cores;
+    b[2] = queued > 255 ? 255 : queued;
+    b[3] = solving;
+    PROTO_PUT_U32(b + 4, ticks * PLATFORM_TICK_MS);
+    PROTO_PUT_U32(b + 8, stats.puzzles);
+    PROTO_PUT_U32(b + 12, stats.solutions);
+    PROTO_PUT_U32(b + 16, net_stats.rx_packets);
+    PROTO_PUT_U32(b + 20, net_stats.tx_packets);
+    PROTO_PUT_U32(b + 24, net_stats.tx_dropped);
+    b += STATS_HEADER_LEN;
+    for (u32 i = 0; i < stats.cores; i++, b += STATS_CORE_LEN)
+    {
+        PROTO_PUT_U32(b, stats.busy_ms[i]);
+        PROTO_PUT_U32(b + 4, stats.runs[i]);
+    }
+
+    net_send(&net_config.telemetry.addr, net_config.telemetry.port, stats_buf, b - stats_buf);
+}
@@ -0,0 +1,29 @@
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#include "xil_types.h"
+#include "hal.h"
+
+// Most solver cores that are timed and reported, every hardware core and the software solver after them
+#define STATS_MAX_CORES (HAL_MAX_CORES + 1)
+
+// Counters for the telemetry packet, like net_stats these are never reset
+typedef struct {
+    u32 puzzles;        // Puzzles and jobs finished, including aborted ones
+    u32 solutions;      // Unique solutions found
+    u32 cores;
+    u32 busy_ms[STATS_MAX_CORES];
+    u32 busy_us[STATS_MAX_CORES];   // Part of a ms not yet added to busy_ms
+    u32 runs[STATS_MAX_CORES];      // Times each core has been started
+    u32 started_us[STATS_MAX_CORES];
+    u8 running[STATS_MAX_CORES];
+} stats_t;
+
+extern stats_t stats;
+
+void stats_init(u32 cores);
+void stats_core_start(u32 core);
+void stats_core_stop(u32 core);
+void stats_poll(u32 queued, u8 solving);
+
+#endif
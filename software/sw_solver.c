@@ -0,0 +1,105 @@
+#include <string.h>
+#include "sw_solver.h"
+
+// This follows hardware/toplevel.c step for step so both find the same solutions in the same order
+
+static void inc_current(sw_solver_t *s)
+{
+    s->current_idx++;
+    if (s->current_x == s->size - 1)
+    {
+        s->current_x = 0;
+        s->current_y++;
+    }
+    else
+        s->current_x++;
+}
+
+static void dec_current(sw_solver_t *s)
+{
+    s->current_idx--;
+    if (s->current_x == 0)
+    {
+        s->current_x = s->size - 1;
+        s->current_y--;
+    }
+    else
+        s->current_x--;
+}
+
+static u8 check_tile(sw_solver_t *s, u8 idx, tile_t tile, u8 init_rot)
+{
+    // Try the tile in each rotation from init_rot, placing it at the current position if one fits
+    for (u8 rot = init_rot; rot < 4; rot++)
+    {
+        u8 valid_top = s->current_y == 0 || s->grid[s->current_idx - s->size].bottom == tile.top;
+        u8 valid_left = s->current_x == 0 || s->grid[s->current_idx - 1].right == tile.left;
+
+        if (valid_top && valid_left)
+        {
+            s->stack[s->current_idx].idx = idx;
+            s->stack[s->current_idx].rot = rot;
+            s->tiles[idx] = tile;
+            s->grid[s->current_idx] = tile;
+            s->used[idx] = 1;
+            inc_current(s);
+            return 1;
+        }
+        tile = tile_rotate(tile);
+    }
+    return 0;
+}
+
+static u8 get_tile(sw_solver_t *s)
+{
+    for (u8 idx = s->stack[s->current_idx].idx; idx < s->total_size; idx++)
+        if (!s->used[idx] && check_tile(s, idx, s->tiles[idx], 0))
+            return 1;
+    return 0;
+}
+
+static void backtrack(sw_solver_t *s)
+{
+    s->stack[s->current_idx].idx = 0;
+    s->stack[s->current_idx].rot = 0;
+    dec_current(s);
+    u8 idx = s->stack[s->current_idx].idx;
+    s->used[idx] = 0;
+
+    // Try the rest of the last tile's rotations before moving on to the next tile
+    if (!check_tile(s, idx, tile_rotate(s->tiles[idx]), s->stack[s->current_idx].rot + 1))
+    {
+        s->stack[s->current_idx].idx++;
+        s->stack[s->current_idx].rot = 0;
+    }
+}
+
+void sw_solver_reset(sw_solver_t *s, const tile_t *tiles, u8 size, u8 start_idx, u8 end_idx)
+{
+    memcpy(s->tiles, tiles, size * size * sizeof(tile_t));
+    memset(s->used, 0, sizeof(s->used));
+    memset(s->stack, 0, sizeof(s->stack));
+    s->stack[0].idx = start_idx;
+    s->current_idx = 0;
+    s->current_x = 0;
+    s->current_y = 0;
+    s->size = size;
+    s->total_size = size * size;
+    s->end_idx = end_idx;
+}
+
+u8 sw_solver_run(sw_solver_t *s, u32 steps)
+{
+    // Each step places or takes back one tile, so the budget bounds how long this takes
+    while (s->stack[0].idx < s->end_idx)
+    {
+        if (steps-- == 0)
+            return SW_SOLVER_BUSY;
+
+        if (!get_tile(s))
+            backtrack(s);
+        else if (s->current_idx == s->total_size)
+            return SW_SOLVER_FOUND;
+    }
+    return SW_SOLVER_DONE;
+}
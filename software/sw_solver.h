@@ -0,0 +1,36 @@
+#ifndef __SW_SOLVER_H_
+#define __SW_SOLVER_H_
+
+#include "xil_types.h"
+#include "puzzle.h"
+
+// What sw_solver_run() stopped for
+#define SW_SOLVER_DONE 0    // Every first tile in the range has been searched
+#define SW_SOLVER_FOUND 1   // A solution is in grid, running again carries on from it
+#define SW_SOLVER_BUSY 2    // The step budget ran out, running again carries on
+
+// A software copy of the search in hardware/toplevel.c
+// The state is all in here rather than in globals so a solver can be stepped a little at a time between other work
+typedef struct {
+    u8 idx;
+    u8 rot;
+} sw_stack_item_t;
+
+typedef struct {
+    tile_t tiles[MAX_SIZE * MAX_SIZE];
+    u8 used[MAX_SIZE * MAX_SIZE];
+    tile_t grid[MAX_SIZE * MAX_SIZE];
+    // One more than the grid, after a solution the search carries on from the position past the last tile
+    sw_stack_item_t stack[MAX_SIZE * MAX_SIZE + 1];
+    u8 current_idx;
+    u8 current_x;
+    u8 current_y;
+    u8 size;
+    u8 total_size;
+    u8 end_idx;
+} sw_solver_t;
+
+void sw_solver_reset(sw_solver_t *s, const tile_t *tiles, u8 size, u8 start_idx, u8 end_idx);
+u8 sw_solver_run(sw_solver_t *s, u32 steps);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * clk_table.h -- Precomputed axi_dynclk settings for the modes in vga_modes.h
+ *
+ * Generated by host/gen_clk_table.c, do not edit by hand.
+ * Regenerate whenever a mode is added to vga_modes.h or the search in dynclk.c changes.
+ */
+
+#ifndef CLK_TABLE_H_
+#define CLK_TABLE_H_
+
+#include "dynclk.h"
+
+static const ClkTableEntry clk_table[] = {
+	/* 640x480@60Hz */
+	{ 25,
+		{ 25, 10, 8, 1 },
+		{ 0x00000104, 0x00000145, 0x00000000, 0x00001041, 0x3E8FA401, 0x004B00E7 } },
+	/* 800x600@60Hz */
+	{ 40,
+		{ 40, 6, 3, 1 },
+		{ 0x00800042, 0x000000C3, 0x00000000, 0x00001041, 0x7E8FA401, 0x0073008C } },
+	/* 1280x1024@60Hz */
+	{ 108,
+		{ 108, 54, 2, 5 },
+		{ 0x00000041, 0x000006DB, 0x00000000, 0x00002083, 0xCFAFA401, 0x00A300FF } },
+	/* 1280x720@60Hz */
+	{ 74.25,
+		{ 74.285714285714292, 52, 2, 7 },
+		{ 0x00000041, 0x0000069A, 0x00000000, 0x000020C4, 0xCFAFA401, 0x00A300FF } },
+	/* 1280x800@60Hz */
+	{ 83.459999999999994,
+		{ 83.333333333333343, 25, 2, 3 },
+		{ 0x00000041, 0x0080030D, 0x00000000, 0x00002042, 0xD90FA401, 0x006300FF } },
+	/* 1440x900@60Hz */
+	{ 106.47,
+		{ 106.66666666666667, 32, 2, 3 },
+		{ 0x00000041, 0x00000410, 0x00000000, 0x00002042, 0xD2CFA401, 0x006300FF } },
+	/* 1680x1050@60Hz */
+	{ 147.13999999999999,
+		{ 147.5, 59, 1, 8 },
+		{ 0x00400041, 0x0080075E, 0x00000000, 0x00000104, 0xCFAFA401, 0x00A300FF } }
+};
+
+#define CLK_TABLE_SIZE (sizeof(clk_table) / sizeof(clk_table[0]))
+
+#endif /* CLK_TABLE_H_ */
@@ -164,9 +164,19 @@ int DisplayStart(DisplayCtrl *dispPtr)
 
 
 	/*
-	 * Calculate the PLL divider parameters based on the required pixel clock frequency
+	 * Look up the PLL divider parameters for the required pixel clock frequency. They are
+	 * precomputed for every mode in vga_modes.h, so only search for them if this is a custom
+	 * pixel clock.
 	 */
-	ClkFindParams(dispPtr->vMode.freq, &clkMode);
+	if (!ClkLookupParams(dispPtr->vMode.freq, &clkMode, &clkReg))
+	{
+		ClkFindParams(dispPtr->vMode.freq, &clkMode);
+		if (!ClkFindReg(&clkReg, &clkMode))
+		{
+			xdbg_printf(XDBG_DEBUG_GENERAL, "Error calculating CLK register values\n\r");
+			return XST_FAILURE;
+		}
+	}
 
 	/*
 	 * Store the obtained frequency to pxlFreq. It is possible that the PLL was not able to
@@ -178,11 +188,6 @@ int DisplayStart(DisplayCtrl *dispPtr)
 	 * Write to the PLL dynamic configuration registers to configure it with the calculated
 	 * parameters.
 	 */
-	if (!ClkFindReg(&clkReg, &clkMode))
-	{
-		xdbg_printf(XDBG_DEBUG_GENERAL, "Error calculating CLK register values\n\r");
-		return XST_FAILURE;
-	}
 	ClkWriteReg(&clkReg, dispPtr->dynClkAddr);
 
 	/*
@@ -355,7 +360,20 @@ int DisplayInitialize(DisplayCtrl *dispPtr, u16 vdmaId, u16 vtcId, u32 dynClkAdd
 	dispPtr->stride = stride;
 	dispPtr->vMode = VMODE_640x480;
 
-	ClkFindParams(dispPtr->vMode.freq, &clkMode);
+	/*
+	 * Look up the PLL divider parameters for the required pixel clock frequency. They are
+	 * precomputed for every mode in vga_modes.h, so only search for them if this is a custom
+	 * pixel clock.
+	 */
+	if (!ClkLookupParams(dispPtr->vMode.freq, &clkMode, &clkReg))
+	{
+		ClkFindParams(dispPtr->vMode.freq, &clkMode);
+		if (!ClkFindReg(&clkReg, &clkMode))
+		{
+			xdbg_printf(XDBG_DEBUG_GENERAL, "Error calculating CLK register values\n\r");
+			return XST_FAILURE;
+		}
+	}
 
 	/*
 	 * Store the obtained frequency to pxlFreq. It is possible that the PLL was not able to
@@ -367,11 +385,6 @@ int DisplayInitialize(DisplayCtrl *dispPtr, u16 vdmaId, u16 vtcId, u32 dynClkAdd
 	 * Write to the PLL dynamic configuration registers to configure it with the calculated
 	 * parameters.
 	 */
-	if (!ClkFindReg(&clkReg, &clkMode))
-	{
-		xdbg_printf(XDBG_DEBUG_GENERAL, "Error calculating CLK register values\n\r");
-		return XST_FAILURE;
-	}
 	ClkWriteReg(&clkReg, dispPtr->dynClkAddr);
 
 	/*
@@ -71,6 +71,7 @@
  */
 
 #include "dynclk.h"
+#include "clk_table.h"
 #include "xil_io.h"
 #include "math.h"
 
@@ -218,6 +219,27 @@ double ClkFindParams(double freq, ClkMode *bestPick)
 	return bestError;
 }
 
+/*
+ * Looks up the clock parameters and register values for freq in the table generated from vga_modes.h.
+ * Returns 1 and fills in both structs if freq is in the table, otherwise 0 and the caller should fall back
+ * to ClkFindParams and ClkFindReg.
+ */
+u32 ClkLookupParams(double freq, ClkMode *clkParams, ClkConfig *regValues)
+{
+	u32 i;
+
+	for (i = 0; i < CLK_TABLE_SIZE; i++)
+	{
+		if (clk_table[i].freq == freq)
+		{
+			*clkParams = clk_table[i].mode;
+			*regValues = clk_table[i].config;
+			return 1;
+		}
+	}
+
+	return 0;
+}
 
 void ClkStart(u32 dynClkAddr)
 {
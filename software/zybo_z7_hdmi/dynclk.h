@@ -39,6 +39,9 @@
  * @desciption
  * Contains a driver for the Digilent axi_dynclk core. To use this driver:
  *
+ * 0) If the frequency is one of the modes in vga_modes.h, ClkLookupParams
+ *    returns both structs below from a precomputed table and steps 1-2 can
+ *    be skipped.
  * 1) Find the ClkMode struct for the frequency closest to your desired
  *    frequency using ClkFindParams.
  * 2) Pass the ClkMode struct to ClkFindReg to obtain the ClkConfig struct
@@ -119,6 +122,15 @@ typedef struct {
 		u32 maindiv;
 } ClkMode;
 
+/*
+ * Precomputed result of ClkFindParams and ClkFindReg for one pixel clock, see clk_table.h
+ */
+typedef struct {
+		double freq; /* Requested pixel clock, as given in the VideoMode */
+		ClkMode mode;
+		ClkConfig config;
+} ClkTableEntry;
+
 /* ------------------------------------------------------------ */
 /*					Variable Declarations						*/
 /* ------------------------------------------------------------ */
@@ -266,6 +278,7 @@ u32 ClkDivider(u32 divide);
 u32 ClkFindReg (ClkConfig *regValues, ClkMode *clkParams);
 void ClkWriteReg (ClkConfig *regValues, u32 dynClkAddr);
 double ClkFindParams(double freq, ClkMode *bestPick);
+u32 ClkLookupParams(double freq, ClkMode *clkParams, ClkConfig *regValues);
 void ClkStart(u32 dynClkAddr);
 void ClkStop(u32 dynClkAddr);
 